@@ -0,0 +1,45 @@
+#ifndef BLACKSMITH_BENCH_BENCHMARK_HPP_
+#define BLACKSMITH_BENCH_BENCHMARK_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Minimal helpers shared by the microbenchmarks: each one times a few variants of the same operation over a buffer and
+// prints the best throughput of a number of repetitions, which is less affected by interrupts than the mean.
+
+/// Returns the size of the benchmark buffer in MiB, given as the first command line argument (or the default).
+inline size_t get_buffer_size(int argc, char **argv, size_t default_mib) {
+  const size_t mib = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : default_mib;
+  return ((mib==0) ? default_mib : mib)*1024*1024;
+}
+
+/// Runs fn repetitions times and prints the best rate, given the amount of work per run in the given unit (e.g., 0.5
+/// and "GB/s" for 512 MB). Returns the value fn returned in the last run, which the caller should use so that the
+/// compiler cannot discard the work.
+template<typename F>
+auto run_benchmark(const std::string &name, double amount, const char *unit, int repetitions, F fn)
+-> decltype(fn()) {
+  using clock = std::chrono::steady_clock;
+  double best_ns = 0;
+  decltype(fn()) result{};
+  for (int i = 0; i < repetitions; ++i) {
+    const auto start = clock::now();
+    result = fn();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+    const auto ns = static_cast<double>(elapsed.count());
+    if (i==0 || ns < best_ns) best_ns = ns;
+  }
+  std::printf("%-32s %10.2f ms %8.2f %s\n", name.c_str(), best_ns/1e6, amount/(best_ns/1e9), unit);
+  return result;
+}
+
+/// Like run_benchmark, for the given number of bytes per run.
+template<typename F>
+auto run_benchmark(const std::string &name, size_t num_bytes, int repetitions, F fn) -> decltype(fn()) {
+  return run_benchmark(name, static_cast<double>(num_bytes)/1e9, "GB/s", repetitions, fn);
+}
+
+#endif //BLACKSMITH_BENCH_BENCHMARK_HPP_
@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "GlobalDefines.hpp"
+#include "Memory/DataGenerator.hpp"
+#include "Memory/RowDigest.hpp"
+#include "Memory/VictimVerifier.hpp"
+
+// Compares checking rows against their expected contents, which have to be generated first, with checking their
+// CRC32C digest against a precomputed one (as Memory does for initialized rows), on a buffer in which every 64th row
+// has a flipped bit. Usage: bench_row_digest [buffer size in MiB]
+int main(int argc, char **argv) {
+  const size_t size = get_buffer_size(argc, argv, 256);
+  const size_t row_size = 8192;
+  const size_t num_rows = size/row_size;
+  const int repetitions = 5;
+
+  auto rows = static_cast<char *>(std::aligned_alloc(CACHELINE_SIZE, size));
+  if (rows==nullptr) {
+    std::fprintf(stderr, "Could not allocate %zu MiB.\n", size/(1024*1024));
+    return EXIT_FAILURE;
+  }
+  const DataGenerator generator(0x5eed);
+  generator.fill(0, rows, size);
+  std::vector<uint32_t> digests(num_rows);
+  for (size_t row = 0; row < num_rows; ++row) digests[row] = RowDigest::crc32c(0, rows + row*row_size, row_size);
+  for (size_t row = 0; row < num_rows; row += 64) rows[row*row_size + row%row_size] ^= 0x01;
+
+  alignas(CACHELINE_SIZE) static char expected[row_size];
+
+  const auto by_memcmp = run_benchmark("generate + memcmp", size, repetitions, [&]() {
+    size_t mismatches = 0;
+    for (size_t row = 0; row < num_rows; ++row) {
+      generator.fill(row*row_size, expected, row_size);
+      mismatches += (std::memcmp(rows + row*row_size, expected, row_size)!=0);
+    }
+    return mismatches;
+  });
+
+  const auto by_lines = run_benchmark("generate + compare_lines", size, repetitions, [&]() {
+    size_t mismatches = 0;
+    for (size_t row = 0; row < num_rows; ++row) {
+      generator.fill(row*row_size, expected, row_size);
+      uint64_t mask = 0;
+      for (size_t line = 0; line < row_size; line += 64*CACHELINE_SIZE)
+        mask |= VictimVerifier::compare_lines(rows + row*row_size + line, expected + line, 64);
+      mismatches += (mask!=0);
+    }
+    return mismatches;
+  });
+
+  // only rows whose digest differs are generated and compared line by line, as in Memory::check_memory
+  const std::string name = std::string("digest first (") + RowDigest::get_kernel_name() + ")";
+  const auto by_digest = run_benchmark(name, size, repetitions, [&]() {
+    size_t mismatches = 0;
+    for (size_t row = 0; row < num_rows; ++row) {
+      if (RowDigest::crc32c(0, rows + row*row_size, row_size)==digests[row]) continue;
+      generator.fill(row*row_size, expected, row_size);
+      mismatches += (std::memcmp(rows + row*row_size, expected, row_size)!=0);
+    }
+    return mismatches;
+  });
+
+  std::free(rows);
+  const size_t num_flipped = (num_rows + 63)/64;
+  if (by_memcmp!=num_flipped || by_lines!=num_flipped || by_digest!=num_flipped) {
+    std::fprintf(stderr, "Mismatch counts differ: %zu (memcmp), %zu (lines), %zu (digest), expected %zu.\n",
+                 by_memcmp, by_lines, by_digest, num_flipped);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
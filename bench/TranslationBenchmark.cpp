@@ -0,0 +1,84 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "GlobalDefines.hpp"
+#include "Memory/TranslationContext.hpp"
+#include "Utilities/BlacksmithConfig.hpp"
+
+// the matrix-vector product over GF(2) computed one parity per output bit, as DRAMAddr did before the lookup tables
+static size_t apply_bitwise(const MemConfiguration &mc, size_t v) {
+  size_t res = 0;
+  for (size_t i = 0; i < mc.WIDTH; ++i) {
+    res <<= 1ULL;
+    res |= (size_t) __builtin_parityl(v & mc.DRAM_MTX[i]);
+  }
+  return res;
+}
+
+// Compares translating virtual addresses to DRAM addresses bit by bit with the lookup tables and the builtin mapping
+// of TranslationContext (single addresses and batches), and checks that all of them compute the same DRAM addresses.
+// Usage: bench_translation <config file> [number of addresses in millions]
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "Usage: %s <config file> [number of addresses in millions]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const BlacksmithConfig config = BlacksmithConfig::from_jsonfile(argv[1]);
+  const size_t millions = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 4;
+  const size_t n = ((millions==0) ? 4 : millions)*1000*1000;
+  const int repetitions = 5;
+
+  // the addresses are only translated, never accessed, so the region does not need to be mapped
+  auto start_address = (volatile char *) (64*(size_t) HUGEPAGE_SIZE);
+  const TranslationContext ctx(config, start_address, 1);
+  const MemConfiguration &mc = ctx.get_mem_config();
+  // a config under another name is not compiled into a builtin mapping (see BuiltinMappings.hpp), so this context
+  // uses the lookup tables
+  BlacksmithConfig renamed = config;
+  renamed.name += " (benchmark)";
+  const TranslationContext lut_ctx(renamed, start_address, 1);
+
+  std::mt19937_64 rng(0x5eed);
+  std::vector<size_t> addrs(n);
+  for (auto &addr : addrs) addr = (size_t) start_address + (rng() & (HUGEPAGE_SIZE - 1));
+  std::vector<size_t> bitwise(n);
+  const double amount = static_cast<double>(n)/1e6;
+
+  run_benchmark("bitwise parity", amount, "M/s", repetitions, [&]() {
+    for (size_t i = 0; i < n; ++i) bitwise[i] = apply_bitwise(mc, addrs[i] & (HUGEPAGE_SIZE - 1));
+    return bitwise[n - 1];
+  });
+
+  // a single and a batch translation per context, reserved so that the references to them stay valid
+  std::vector<std::vector<size_t>> results;
+  results.reserve(4);
+  for (const TranslationContext *c : {&lut_ctx, &ctx}) {
+    const std::string translator = (c==&lut_ctx) ? "lookup tables" : "builtin mapping";
+    results.emplace_back(n);
+    auto &single = results.back();
+    run_benchmark("to_dram (" + translator + ")", amount, "M/s", repetitions, [&]() {
+      for (size_t i = 0; i < n; ++i) single[i] = c->to_dram(addrs[i]);
+      return single[n - 1];
+    });
+    results.emplace_back(n);
+    auto &batch = results.back();
+    run_benchmark(std::string("to_dram_batch (") + c->get_batch_kernel_name() + ")", amount, "M/s", repetitions, [&]() {
+      c->to_dram_batch(addrs.data(), batch.data(), n);
+      return batch[n - 1];
+    });
+  }
+
+  for (const auto &result : results) {
+    for (size_t i = 0; i < n; ++i) {
+      if (result[i]==bitwise[i]) continue;
+      std::fprintf(stderr, "Translations of %p differ: %zx instead of %zx.\n",
+                   (void *) addrs[i], result[i], bitwise[i]);
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Benchmark.hpp"
+#include "GlobalDefines.hpp"
+#include "Memory/DataGenerator.hpp"
+#include "Memory/VictimVerifier.hpp"
+
+// Compares the victim verification kernels with memcmp on a buffer in which every 1024th cache line has a flipped bit.
+// Usage: bench_victim_verifier [buffer size in MiB]
+int main(int argc, char **argv) {
+  const size_t size = get_buffer_size(argc, argv, 256);
+  const size_t num_lines = size/CACHELINE_SIZE;
+  const int repetitions = 5;
+
+  auto actual = static_cast<char *>(std::aligned_alloc(CACHELINE_SIZE, size));
+  auto expected = static_cast<char *>(std::aligned_alloc(CACHELINE_SIZE, size));
+  if (actual==nullptr || expected==nullptr) {
+    std::fprintf(stderr, "Could not allocate %zu MiB.\n", 2*size/(1024*1024));
+    return EXIT_FAILURE;
+  }
+  const DataGenerator generator(0x5eed);
+  generator.fill(0, expected, size);
+  std::memcpy(actual, expected, size);
+  for (size_t line = 0; line < num_lines; line += 1024) actual[line*CACHELINE_SIZE + line%CACHELINE_SIZE] ^= 0x10;
+
+  const size_t page_size = 4096;
+  const auto by_page = run_benchmark("memcmp (per page)", size, repetitions, [&]() {
+    size_t mismatches = 0;
+    for (size_t offset = 0; offset < size; offset += page_size) {
+      if (std::memcmp(actual + offset, expected + offset, page_size)==0) continue;
+      // like the page-based check, compare the lines of a differing page one by one
+      for (size_t line = offset; line < offset + page_size; line += CACHELINE_SIZE)
+        mismatches += (std::memcmp(actual + line, expected + line, CACHELINE_SIZE)!=0);
+    }
+    return mismatches;
+  });
+
+  const auto by_line = run_benchmark("memcmp (per cache line)", size, repetitions, [&]() {
+    size_t mismatches = 0;
+    for (size_t offset = 0; offset < size; offset += CACHELINE_SIZE)
+      mismatches += (std::memcmp(actual + offset, expected + offset, CACHELINE_SIZE)!=0);
+    return mismatches;
+  });
+
+  const std::string name = std::string("VictimVerifier (") + VictimVerifier::get_kernel_name() + ")";
+  const auto by_kernel = run_benchmark(name, size, repetitions, [&]() {
+    size_t mismatches = 0;
+    for (size_t line = 0; line < num_lines; line += 64) {
+      const uint64_t mask = VictimVerifier::compare_lines(actual + line*CACHELINE_SIZE,
+                                                          expected + line*CACHELINE_SIZE, 64);
+      mismatches += static_cast<size_t>(__builtin_popcountll(mask));
+    }
+    return mismatches;
+  });
+
+  std::free(actual);
+  std::free(expected);
+  const size_t num_flipped = (num_lines + 1023)/1024;
+  if (by_page!=num_flipped || by_line!=num_flipped || by_kernel!=num_flipped) {
+    std::fprintf(stderr, "Mismatch counts differ: %zu (page), %zu (line), %zu (kernel), expected %zu.\n",
+                 by_page, by_line, by_kernel, num_flipped);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+# Generates a file that defines the address mapping matrix (DRAM_MTX) of each config in CONFIG_DIR as a BUILTIN_MAPPING
+# entry, so that DRAMAddr can use a translator specialized for it at compile time (see Memory/BuiltinMappings.hpp).
+#
+# Usage: cmake -DCONFIG_DIR=<dir> -DOUTPUT=<file> -P GenerateBuiltinMappings.cmake
+
+cmake_minimum_required(VERSION 3.19)
+
+# must match BUILTIN_MTX_SIZE in Memory/BuiltinMappings.hpp
+set(MTX_SIZE 30)
+
+# converts a bit definition (a single bit or an array of bits that are XORed) to its bit mask
+function(bitdef_to_mask json_def out_var)
+    string(JSON def_type TYPE "${json_def}")
+    set(mask 0)
+    if (def_type STREQUAL "ARRAY")
+        string(JSON num_bits LENGTH "${json_def}")
+        math(EXPR last "${num_bits} - 1")
+        foreach (i RANGE ${last})
+            string(JSON bit GET "${json_def}" ${i})
+            math(EXPR mask "${mask} | (1 << ${bit})")
+        endforeach ()
+    else ()
+        math(EXPR mask "1 << ${json_def}")
+    endif ()
+    math(EXPR mask "${mask}" OUTPUT_FORMAT HEXADECIMAL)
+    set(${out_var} ${mask} PARENT_SCOPE)
+endfunction()
+
+file(GLOB config_files "${CONFIG_DIR}/*.json")
+list(SORT config_files)
+
+set(entries "")
+foreach (config_file ${config_files})
+    file(READ "${config_file}" json)
+    string(JSON name GET "${json}" name)
+
+    # the rows of DRAM_MTX are ordered like in BlacksmithConfig::to_memconfig: bank, column, then row bits
+    set(masks "")
+    set(num_rows 0)
+    foreach (key bank_bits col_bits row_bits)
+        string(JSON num_defs LENGTH "${json}" ${key})
+        math(EXPR last "${num_defs} - 1")
+        foreach (i RANGE ${last})
+            string(JSON def GET "${json}" ${key} ${i})
+            bitdef_to_mask("${def}" mask)
+            list(APPEND masks "${mask}")
+            math(EXPR num_rows "${num_rows} + 1")
+        endforeach ()
+        set(num_${key} ${num_defs})
+    endforeach ()
+
+    if (NOT num_rows EQUAL MTX_SIZE)
+        # wider mappings depend on the physical location of each superpage and are always translated at runtime
+        message(STATUS "Not compiling in ${config_file}: it defines ${num_rows} instead of ${MTX_SIZE} bits.")
+        continue()
+    endif ()
+
+    string(MAKE_C_IDENTIFIER "${name}" identifier)
+    list(JOIN masks ", " masks_str)
+    string(APPEND entries
+            "BUILTIN_MAPPING(${identifier}, \"${name}\", ${num_bank_bits}, ${num_col_bits}, ${num_row_bits},\n"
+            "                {${masks_str}})\n")
+endforeach ()
+
+file(WRITE "${OUTPUT}" "// generated by cmake/GenerateBuiltinMappings.cmake from the configs in config/, do not edit\n\n${entries}")
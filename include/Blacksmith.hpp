@@ -1,15 +1,21 @@
 #ifndef BLACKSMITH_INCLUDE_BLACKSMITH_HPP_
 #define BLACKSMITH_INCLUDE_BLACKSMITH_HPP_
 
+#include <optional>
 #include <string>
 #include <unordered_set>
+#include <vector>
 #include <GlobalDefines.hpp>
+#include "Memory/RegionScrubber.hpp"
+#include "Utilities/Enums.hpp"
 #include "Utilities/RasWatcher.hpp"
 
 // defines the program's arguments and their default values
 struct ProgramArguments {
   // path to JSON config
   std::string config;
+  // path the config determined by --discover-config is written to (empty = no discovery, fuzz with the config instead)
+  std::string discover_config;
   // the duration of the fuzzing run in hours
   size_t runtime_limit = 3;
   // path to logfile
@@ -18,15 +24,37 @@ struct ProgramArguments {
   size_t num_dram_locations_per_mapping = 3;
   // number of effective hammering patterns to be found for a run to end before its runtime limit
   size_t effective_patterns = 3;
+  // number of 1 GB superpages to allocate
+  size_t memory = 1;
+  // seed of the data the memory is initialized with (none = pick a random seed)
+  std::optional<uint64_t> seed;
+  // initialize rows only when they are used for the first time instead of initializing all memory at startup
+  bool lazy_init = false;
+  // the data patterns written to the aggressor and victim rows, the probes rotate through them
+  std::vector<DATA_PATTERN> data_patterns{DATA_PATTERN::RANDOM};
+  // throughput of the background scrubber in MiB/s (0 = no scrubber)
+  size_t scrub_rate = 0;
   // total number of mappings (i.e., Aggressor ID -> DRAM rows mapping) to try for a pattern
   size_t num_address_mappings_per_pattern = 3;
+  // path to the cache of timing calibrations, which lets later runs on the same system skip them (empty = the file
+  // calibration_cache.json in the directory of the logfile)
+  std::string calibration_cache;
+  // calibrate even if the cache holds a calibration for this system (the new one replaces it)
+  bool recalibrate = false;
 };
 
 extern ProgramArguments program_args;
+// timestamp (in us) of the program's start, used to report the time until hammering begins
+extern int64_t program_start_ts_us;
 extern RasWatcher *ras_watcher;
+// the background scrubber, nullptr if disabled
+extern RegionScrubber *region_scrubber;
 
 int main(int argc, char **argv);
 
 void handle_args(int argc, char **argv);
 
+// determines the address mapping by timing row conflicts and writes it to the file given by --discover-config
+void run_config_discovery();
+
 #endif //BLACKSMITH_INCLUDE_BLACKSMITH_HPP_
@@ -7,6 +7,7 @@
 #define BLACKSMITH_SRC_FORGES_FUZZYHAMMERER_HPP_
 
 #include "Fuzzer/HammeringPattern.hpp"
+#include "Fuzzer/SyncDriftDetector.hpp"
 #include "Memory/Memory.hpp"
 
 class FuzzyHammerer {
@@ -26,10 +27,17 @@ class FuzzyHammerer {
   // note: it does not consider the bit flips triggered during the reproducibility runs
   static std::unordered_map<std::string, std::unordered_map<std::string, int>> map_pattern_mappings_bitflips;
 
-  static void do_random_accesses(const std::vector<volatile char *>& random_rows, int duration_us);
+  // tracks how the hammering runs synchronize with the refreshes, to measure the activations per refresh interval again
+  // once they no longer match
+  static SyncDriftDetector sync_drift_detector;
+
+  // whether a pattern has been hammered since the program started, to report the startup time only once
+  static bool hammered_before;
+
+  static void do_random_accesses(const std::vector<volatile char *> &random_rows, int duration_us);
 
   static void
-  n_sided_frequency_based_hammering(BlacksmithConfig &config, DramAnalyzer &dramAnalyzer, Memory &memory,
+  n_sided_frequency_based_hammering(const TranslationContext &ctx, DramAnalyzer &dramAnalyzer, Memory &memory,
                                     uint64_t acts, size_t runtime_limit, size_t probes_per_pattern);
 
   static void probe_mapping_and_scan(PatternAddressMapper &mapper, Memory &memory,
@@ -38,7 +46,7 @@ class FuzzyHammerer {
   static void log_overall_statistics(size_t cur_round, const std::string &best_mapping_id,
                                      size_t best_mapping_num_bitflips, size_t num_effective_patterns);
 
-  static void generate_pattern_for_ARM(BlacksmithConfig &config,
+  static void generate_pattern_for_ARM(const TranslationContext &ctx,
                                        size_t acts,
                                        int *rows_to_access,
                                        int max_accesses,
@@ -59,9 +59,13 @@ class CodeJitter {
                   int num_aggressors_for_sync,
                   int total_num_activations);
 
-  /// does the hammering if the function was previously created successfully, otherwise does nothing
+  /// does the hammering if the function was previously created successfully, otherwise does nothing; returns the total
+  /// number of activations of the synchronizations with the refreshes (or -1 if nothing was hammered)
   int hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool verbose);
 
+  /// estimates the number of refreshes the last jitted function synchronizes with while hammering (at least 1)
+  [[nodiscard]] int get_num_synced_refs(const FuzzingParameterSet &fuzzing_parameters) const;
+
   /// cleans this instance associated function pointer that points to the function that was jitted at runtime;
   /// cleaning up is required to release memory before jit_strict can be called again
   void cleanup();
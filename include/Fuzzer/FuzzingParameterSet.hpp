@@ -9,6 +9,7 @@
 #include <random>
 #include <unordered_map>
 
+#include "Memory/RefreshProfiler.hpp"
 #include "Utilities/Range.hpp"
 #include "Utilities/Enums.hpp"
 
@@ -31,6 +32,13 @@ class FuzzingParameterSet {
 
   int hammering_total_num_activations;
 
+  /// The duration of hammering a pattern at one location if the refresh interval is known: 5M activations at about
+  /// 100 activations per 7.8us.
+  static constexpr double HAMMERING_DURATION_US = 390000;
+
+  /// The refresh cadence profiled on this system; if it is not valid, DDR4's nominal tREFI of 7.8us is assumed.
+  RefreshProfile refresh_profile;
+
   int base_period;
 
   int max_row_no;
@@ -55,14 +63,23 @@ class FuzzingParameterSet {
 
   std::discrete_distribution<int> N_sided_probabilities;
 
+  // the data patterns that the probes rotate through
+  std::vector<DATA_PATTERN> data_patterns{DATA_PATTERN::RANDOM};
+
+  size_t next_data_pattern = 0;
+
   [[nodiscard]] std::string get_dist_string() const;
 
+  [[nodiscard]] double get_trefi_us() const;
+
+  void update_hammering_total_num_activations();
+
   void set_distribution(Range<int> range_N_sided, std::unordered_map<int, int> probabilities);
 
  public:
   FuzzingParameterSet() = default;
 
-  explicit FuzzingParameterSet(int measured_num_acts_per_ref);
+  FuzzingParameterSet(int measured_num_acts_per_ref, size_t num_rows);
 
   FLUSHING_STRATEGY flushing_strategy;
 
@@ -104,6 +121,11 @@ class FuzzingParameterSet {
 
   int get_random_wait_until_start_hammering_us();
 
+  /// Returns the data pattern for the next probe, rotating through the configured data patterns.
+  DATA_PATTERN get_next_data_pattern();
+
+  void set_data_patterns(const std::vector<DATA_PATTERN> &patterns);
+
   [[nodiscard]] int get_num_refresh_intervals() const;
 
   [[nodiscard]] int get_num_base_periods() const;
@@ -122,11 +144,15 @@ class FuzzingParameterSet {
 
   void print_static_parameters() const;
 
-  static void print_dynamic_parameters(int bank, bool seq_addresses, int start_row);
+  static void print_dynamic_parameters(size_t page, int bank, bool seq_addresses, int start_row);
 
   static void print_dynamic_parameters2(bool sync_at_each_ref, int wait_until_hammering_us, int num_aggs_for_sync);
 
   void set_num_activations_per_t_refi(int num_activations_per_t_refi);
+
+  /// Sizes the hammering duration and the wait before hammering according to the given refresh cadence. An invalid
+  /// profile is ignored, i.e., the last valid one (or the nominal tREFI if there was none) is kept.
+  void set_refresh_profile(const RefreshProfile &profile);
 };
 
 #endif //BLACKSMITH_INCLUDE_FUZZER_FUZZINGPARAMETERSET_HPP_
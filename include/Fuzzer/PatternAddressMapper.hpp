@@ -20,7 +20,8 @@
 #include "Fuzzer/BitFlip.hpp"
 #include "Fuzzer/FuzzingParameterSet.hpp"
 #include "Fuzzer/CodeJitter.hpp"
-#include "Utilities/BlacksmithConfig.hpp"
+#include "Memory/DramGeometry.hpp"
+#include "Memory/TranslationContext.hpp"
 
 class PatternAddressMapper {
  private:
@@ -29,7 +30,8 @@ class PatternAddressMapper {
                                std::vector<volatile char *> &addresses,
                                std::vector<int> &rows);
 
-  std::unordered_set<volatile char *> victim_rows;
+  // the rows around the aggressors that are checked for bit flips, sorted and without duplicates
+  std::vector<DRAMAddr> victim_rows;
 
   // the unique identifier of this pattern-to-address mapping
   std::string instance_id;
@@ -37,12 +39,15 @@ class PatternAddressMapper {
   // a randomization engine
   std::mt19937 gen;
 
+  // the context the aggressors' addresses are translated with, nullptr for mappings deserialized from JSON
+  const TranslationContext *ctx = nullptr;
+
  public:
   std::unique_ptr<CodeJitter> code_jitter;
 
   PatternAddressMapper();
 
-  explicit PatternAddressMapper(uint64_t total_banks);
+  explicit PatternAddressMapper(const TranslationContext &ctx);
 
   // copy constructor
   PatternAddressMapper(const PatternAddressMapper& other);
@@ -54,12 +59,18 @@ class PatternAddressMapper {
   size_t min_row = 0;
   size_t max_row = 0;
   int bank_no = 0;
+  size_t page_no = 0;
 
   // a global counter that makes sure that we test patterns on all banks equally often
   // it is incremented for each mapping and reset to 0 once we tested all banks (depending on num_probes_per_pattern
-  // this may happen after we tested more than one pattern)
+  // this may happen after we tested more than one pattern); TranslationContext::spread_bank maps it to the bank
   static int bank_counter;
 
+  // a global counter that selects the superpage of the memory pool, it is incremented each time bank_counter is reset
+  // so that all banks of all superpages are tested equally often; TranslationContext::spread_page maps it to the
+  // superpage
+  static size_t page_counter;
+
   // a mapping from aggressors included in this pattern to memory addresses (DRAMAddr)
   std::unordered_map<AGGRESSOR_ID_TYPE, DRAMAddr> aggressor_to_addr;
 
@@ -74,6 +85,12 @@ class PatternAddressMapper {
   //    0.4 => 40%: was reproducible in 40% of all reproducibility runs executed
   int reproducibility_score = -1;
 
+  // the data the aggressor and victim rows are initialized with before hammering this mapping
+  DATA_PATTERN data_pattern = DATA_PATTERN::RANDOM;
+
+  // the seed of the memory's data (see Memory::get_seed), needed to reproduce the expected contents of random data
+  uint64_t data_seed = 0;
+
   uint64_t total_banks;
 
   // chooses new addresses for the aggressors involved in its referenced HammeringPattern
@@ -91,9 +108,11 @@ class PatternAddressMapper {
 
   void export_pattern(std::vector<Aggressor> &aggressors, size_t base_period, int *rows, size_t max_rows);
 
-  [[nodiscard]] const std::unordered_set<volatile char *> & get_victim_rows() const;
+  [[nodiscard]] const std::vector<DRAMAddr> & get_victim_rows() const;
 
-  std::vector<volatile char *> get_random_nonaccessed_rows(int row_upper_bound);
+  // returns 1024 random rows of the mapping's bank beyond its aggressors, computed lazily when iterated (so callers
+  // that access them in a timed loop should copy them into a vector first)
+  RandomBankRows get_random_nonaccessed_rows(int row_upper_bound);
 
   void determine_victims(const std::vector<AggressorAccessPattern> &agg_access_patterns);
 
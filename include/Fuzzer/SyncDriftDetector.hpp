@@ -0,0 +1,53 @@
+#ifndef BLACKSMITH_INCLUDE_FUZZER_SYNCDRIFTDETECTOR_HPP_
+#define BLACKSMITH_INCLUDE_FUZZER_SYNCDRIFTDETECTOR_HPP_
+
+#include <cstddef>
+#include <deque>
+
+#include "Utilities/RunningStats.hpp"
+
+// Tells whether the hammering still synchronizes with the refreshes as it did right after the number of activations
+// per refresh interval was measured. Each hammering run reports how many rounds of timed accesses a synchronization
+// took on average; if the activations per refresh interval no longer match the refresh cadence, the hammering ends
+// further away from a refresh, and the synchronizations take longer (or shorter). The first window_size runs after a
+// reset form the baseline, which is compared to a sliding window of the last window_size runs.
+class SyncDriftDetector {
+ private:
+  size_t window_size;
+
+  // the relative difference between the means of the window and the baseline beyond which they drifted apart
+  double max_relative_drift;
+
+  // the difference must also be at least this many standard errors, so that a window of unusual patterns does not
+  // count as drift
+  double min_significance;
+
+  RunningStats baseline;
+
+  std::deque<double> window;
+
+ public:
+  explicit SyncDriftDetector(size_t window_size = 128, double max_relative_drift = 0.35, double min_significance = 4.0);
+
+  /// Adds the average number of rounds the synchronizations of a hammering run took.
+  void add(double sync_rounds);
+
+  /// Returns whether the window drifted away from the baseline.
+  [[nodiscard]] bool has_drifted() const;
+
+  /// Forgets the baseline and the window, e.g., after the activations per refresh interval were measured again.
+  void reset();
+
+  [[nodiscard]] double get_baseline_mean() const {
+    return baseline.get_mean();
+  }
+
+  /// Returns the mean of the window (0 if it is empty).
+  [[nodiscard]] double get_window_mean() const;
+
+  [[nodiscard]] size_t get_window_size() const {
+    return window_size;
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_FUZZER_SYNCDRIFTDETECTOR_HPP_
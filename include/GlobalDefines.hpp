@@ -37,7 +37,10 @@ uint64_t static inline GB(uint64_t value) {
 // ################### CONFIG PARAMETERS ##################
 // ########################################################
 
-// number of bytes to be allocated
-#define MEM_SIZE (GB(1))
+// size of a cache line, the granularity at which memory is verified
+#define CACHELINE_SIZE (64UL)
+
+// size of a superpage, the memory is allocated as a pool of these
+#define HUGEPAGE_SIZE (GB(1))
 
 #endif /* GLOBAL_DEFINES */
@@ -0,0 +1,86 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_BUILTINMAPPINGS_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_BUILTINMAPPINGS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Memory/TranslationContext.hpp"
+#include "Utilities/GF2Matrix.hpp"
+
+// only mappings confined to a superpage are compiled in, wider ones depend on physical addresses anyway
+#define BUILTIN_MTX_SIZE SUPERPAGE_BITS
+
+typedef std::array<size_t, BUILTIN_MTX_SIZE> mapping_matrix;
+
+/// Inverts a matrix over GF(2) given in the format of MemConfiguration, i.e., row r computes bit BUILTIN_MTX_SIZE-1-r
+/// of the product. Returns the zero matrix if the matrix is singular.
+constexpr mapping_matrix invert_gf2(const mapping_matrix &mtx) {
+  GF2Matrix m(BUILTIN_MTX_SIZE, BUILTIN_MTX_SIZE);
+  for (size_t r = 0; r < BUILTIN_MTX_SIZE; ++r) m.set_row(BUILTIN_MTX_SIZE - 1 - r, mtx[r]);
+  GF2Matrix inverse;
+  mapping_matrix inv{};
+  if (!m.inverse(inverse)) return inv;
+  for (size_t r = 0; r < BUILTIN_MTX_SIZE; ++r) inv[BUILTIN_MTX_SIZE - 1 - r] = inverse.get_row(r);
+  return inv;
+}
+
+/// Splits the product with a matrix into terms (v & mask) shifted by the same distance: output bit o depends on input
+/// bit b iff row BUILTIN_MTX_SIZE-1-o contains b, which is expressed by bit b in the mask of the shift o-b. The mask of
+/// shift d is stored at index d + 63.
+constexpr std::array<size_t, 64 + BUILTIN_MTX_SIZE> to_shift_masks(const mapping_matrix &mtx) {
+  std::array<size_t, 64 + BUILTIN_MTX_SIZE> masks{};
+  for (size_t o = 0; o < BUILTIN_MTX_SIZE; ++o) {
+    for (size_t b = 0; b < 64; ++b) {
+      if ((mtx[BUILTIN_MTX_SIZE - 1 - o] >> b) & 1ULL) masks[o + 63 - b] |= 1ULL << b;
+    }
+  }
+  return masks;
+}
+
+template<const mapping_matrix &Mtx>
+inline constexpr auto shift_masks = to_shift_masks(Mtx);
+
+template<const mapping_matrix &Mtx, size_t I>
+[[gnu::always_inline]] inline size_t shift_term(size_t v) {
+  constexpr size_t mask = shift_masks<Mtx>[I];
+  constexpr int shift = static_cast<int>(I) - 63;
+  // all but a handful of the masks are zero for real mappings
+  if constexpr (mask==0) {
+    return 0;
+  } else if constexpr (shift >= 0) {
+    return (v & mask) << shift;
+  } else {
+    return (v & mask) >> -shift;
+  }
+}
+
+template<const mapping_matrix &Mtx, size_t... I>
+[[gnu::always_inline]] inline size_t apply_shift_terms(size_t v, std::index_sequence<I...>) {
+  return (shift_term<Mtx, I>(v) ^ ...);
+}
+
+/// Computes the product of the matrix Mtx, known at compile time, and v. This is always optimized as the library
+/// itself is built without optimizations.
+template<const mapping_matrix &Mtx>
+__attribute__((optimize("O2"))) size_t apply_builtin_matrix(size_t v) {
+  return apply_shift_terms<Mtx>(v, std::make_index_sequence<64 + BUILTIN_MTX_SIZE>{});
+}
+
+// an address mapping of a config shipped in config/, with translators specialized for its matrices
+struct BuiltinMapping {
+  const char *name;
+  size_t num_bank_bits;
+  size_t num_col_bits;
+  size_t num_row_bits;
+  const mapping_matrix *dram_mtx;
+  const mapping_matrix *addr_mtx;
+  size_t (*to_dram)(size_t);
+  size_t (*to_addr)(size_t);
+};
+
+/// Returns the mappings of all configs in config/, generated from the JSON files at build time.
+const std::vector<BuiltinMapping> &get_builtin_mappings();
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_BUILTINMAPPINGS_HPP_
@@ -0,0 +1,67 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_CALIBRATIONCACHE_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_CALIBRATIONCACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Memory/RefreshProfiler.hpp"
+#include "Utilities/BlacksmithConfig.hpp"
+
+// the results of DramAnalyzer::analyze_dram
+struct Calibration {
+  size_t conflict_threshold = 0;
+  std::vector<size_t> bank_thresholds;
+  size_t acts_per_trefi = 0;
+  // whether the config was checked (see DramAnalyzer::check_addr_function), and the share of mismatching address pairs
+  bool config_checked = false;
+  double config_mismatch_rate = 0;
+  RefreshProfile refresh_profile;
+};
+
+void to_json(nlohmann::json &j, const Calibration &c);
+
+void from_json(const nlohmann::json &j, Calibration &c);
+
+// A JSON file of calibrations, each stored for the system it was measured on: the host, the config, the CPU (model
+// and microcode), and the DIMMs (serial numbers from the SMBIOS memory device entries, which are only readable as
+// root). The timing calibration rarely changes as long as none of these do, so a later run on the same system can
+// reuse it instead of measuring it again.
+class CalibrationCache {
+ private:
+  std::string filepath;
+
+  // the properties of this system that the entries are matched against
+  std::string hostname;
+  std::string config_hash;
+  std::string cpu_model;
+  std::string microcode;
+  std::vector<std::string> dimm_serials;
+
+  // the contents of the file, {"entries": [...]}
+  nlohmann::json contents;
+
+  // returns whether the entry was stored for this system
+  [[nodiscard]] bool matches(const nlohmann::json &entry) const;
+
+  // computes the 64-bit FNV-1a hash of the config's JSON representation
+  static std::string hash_config(const BlacksmithConfig &config);
+
+  // returns the serial numbers of all populated DIMMs (SMBIOS type 17 entries), sorted
+  static std::vector<std::string> get_dimm_serials();
+
+ public:
+  /// Loads the cache from the given file (if it exists) and determines the properties of this system.
+  CalibrationCache(const std::string &filepath, const BlacksmithConfig &config);
+
+  /// Looks up the calibration stored for this system. Returns false if there is none.
+  bool lookup(Calibration &calibration) const;
+
+  /// Stores the calibration for this system, replacing any older one, and writes the cache to its file.
+  void store(const Calibration &calibration);
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_CALIBRATIONCACHE_HPP_
@@ -0,0 +1,115 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_CONFIGDISCOVERY_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_CONFIGDISCOVERY_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Memory/TimingSource.hpp"
+#include "Memory/TranslationContext.hpp"
+#include "Utilities/BlacksmithConfig.hpp"
+
+// Reverse engineers the address mapping of a superpage by timing row conflicts, like DRAMA, and turns it into a config.
+//
+// Two addresses conflict (i.e., are in the same bank but different rows) depending only on their XOR difference, as
+// the mapping is linear: the differences of all same-bank addresses form a subspace, whose complement is spanned by the
+// bank functions. The conflict set of any address is thus a coset of that subspace, which is found by collecting
+// conflicting differences until their span stops growing. The row bits are then those whose same-bank differences
+// conflict, and the column bits are the remaining ones not needed to tell the banks apart.
+//
+// All timing goes through a TimingSource, so that the discovery can be run against a synthetic timing oracle (see
+// SyntheticTimingSource and tests/ConfigDiscoveryTest.cpp).
+class ConfigDiscovery {
+ public:
+  // the number of repetitions each measurement on real DRAM averages over (see DramTimingSource)
+  static constexpr size_t MEASURE_ROUNDS = 1000;
+
+ private:
+  // the number of random address pairs timed between two checks whether the conflicts are separated from the other
+  // pairs, and in total at least and at most; as only one in (number of banks) pairs conflicts, this takes far more
+  // samples than DramAnalyzer's calibration, which knows which pairs conflict
+  static constexpr size_t THRESHOLD_BATCH = 256;
+  static constexpr size_t THRESHOLD_MIN_SAMPLES = 1024;
+  static constexpr size_t THRESHOLD_MAX_SAMPLES = 32768;
+
+  // the number of random differences after which the search for same-bank differences gives up
+  static constexpr size_t MAX_CANDIDATES = 200000;
+
+  // the number of consecutive conflicting differences that must already be in the span of those found before, which
+  // makes it unlikely (< 2^-32) that the span is still smaller than the subspace of same-bank differences
+  static constexpr size_t STABLE_CONFLICTS = 32;
+
+  // the number of measurements (all at different addresses) that must agree before a difference that grows the span
+  // is accepted, as a single false positive would add a wrong dimension to the span
+  static constexpr size_t CONFIRM_VOTES = 5;
+
+  // the number of measurements a difference is classified by (by majority) when finding the row bits
+  static constexpr size_t ROW_VOTES = 5;
+
+  // the number of address pairs of each kind (same bank and different row, same row, different bank) that are timed
+  // to validate the discovered mapping, and the share of them that must match the mapping
+  static constexpr size_t VALIDATION_PAIRS = 300;
+  static constexpr double VALIDATION_MIN_AGREEMENT = 0.95;
+
+  // the bits of an offset within a cache line, which cannot be told apart by timing and are always column bits
+  static constexpr size_t CACHELINE_BITS = 6;
+
+  volatile char *superpage;
+
+  TimingSource &timing;
+
+  std::mt19937_64 gen;
+
+  size_t threshold = 0;
+
+  size_t num_measurements = 0;
+
+  // a basis of the same-bank differences found so far, indexed by the highest bit of each basis vector
+  std::array<uint64_t, SUPERPAGE_BITS> same_bank_basis{};
+
+  size_t same_bank_dims = 0;
+
+  // times the accesses to a random cache line and the one at the given difference from it
+  uint64_t measure_diff(uint64_t diff);
+
+  // measures the difference up to `rounds' times, each at a different address, and returns whether at least
+  // `required' of them were conflicts; stops as soon as the outcome is certain
+  bool is_conflict(uint64_t diff, size_t rounds, size_t required);
+
+  // reduces v by the basis of same-bank differences, which leaves 0 iff v is in their span
+  [[nodiscard]] uint64_t reduce(uint64_t v) const;
+
+  // determines the threshold between the access times of conflicts and all other address pairs
+  bool determine_threshold();
+
+  // collects conflicting differences until their span is the subspace of all same-bank differences
+  bool find_same_bank_differences();
+
+  // returns a basis of the bank functions with as few bits per function as possible
+  [[nodiscard]] std::vector<uint64_t> solve_bank_functions() const;
+
+  // determines the row bits by checking for each address bit whether a same-bank difference containing it conflicts
+  std::vector<size_t> find_row_bits(const std::vector<uint64_t> &bank_functions);
+
+  // times address pairs of the mapping described by config and checks whether they conflict as the mapping predicts
+  bool validate(const BlacksmithConfig &config);
+
+ public:
+  /// Creates a discovery for the superpage starting at the given address, whose accesses are timed by the given
+  /// source (which must outlive the discovery). The seed determines the addresses that are timed.
+  ConfigDiscovery(volatile char *superpage, TimingSource &timing, uint64_t seed);
+
+  /// Determines the address mapping within the superpage and returns it as a config of the given name, which has been
+  /// validated against further measurements. Exits if no consistent mapping could be found.
+  BlacksmithConfig discover(const std::string &name);
+
+  /// Returns the number of address pairs timed so far.
+  [[nodiscard]] size_t get_num_measurements() const {
+    return num_measurements;
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_CONFIGDISCOVERY_HPP_
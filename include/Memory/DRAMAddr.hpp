@@ -6,92 +6,94 @@
 #ifndef DRAMADDR
 #define DRAMADDR
 
+#include <array>
 #include <map>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
-struct MemConfiguration; // forward declaration needed to break include cycle
-
 #ifdef ENABLE_JSON
 #include <nlohmann/json.hpp>
 #endif
 
-#include "Utilities/BlacksmithConfig.hpp"
-
-#define MTX_SIZE (30U)
-
-struct MemConfiguration {
-  size_t BK_SHIFT;
-  size_t BK_MASK;
-  size_t ROW_SHIFT;
-  size_t ROW_MASK;
-  size_t COL_SHIFT;
-  size_t COL_MASK;
-  std::array<size_t, MTX_SIZE> DRAM_MTX;
-  std::array<size_t, MTX_SIZE> ADDR_MTX;
-};
+#include "Memory/TranslationContext.hpp"
 
 class DRAMAddr {
  private:
-  // Class attributes
-  static MemConfiguration MemConfig;
-  static BlacksmithConfig *Config;
-  static size_t base_msb;
+  // the context this address is translated with, nullptr for addresses deserialized from JSON
+  const TranslationContext *ctx = nullptr;
+
+  [[nodiscard]] const TranslationContext &context() const {
+    if (ctx==nullptr) {
+      throw std::logic_error("DRAMAddr has no translation context");
+    }
+    return *ctx;
+  }
 
   [[nodiscard]] size_t linearize() const;
 
+  [[nodiscard]] size_t get_absolute_bank() const;
+
  public:
   size_t bank{};
   size_t row{};
   size_t col{};
-
-  // class methods
-  static void set_base_msb(void *buff);
-
-  static void set_config(BlacksmithConfig &config);
+  // the superpage of the memory pool this address lies in
+  size_t page{};
 
   // instance methods
-  DRAMAddr(size_t bk, size_t r, size_t c);
+  DRAMAddr(const TranslationContext &ctx, size_t bk, size_t r, size_t c, size_t pg = 0);
 
-  explicit DRAMAddr(void *addr);
+  DRAMAddr(const TranslationContext &ctx, void *addr);
 
   // must be DefaultConstructible for JSON (de-)serialization
   DRAMAddr();
 
+  [[nodiscard]] const TranslationContext &get_context() const {
+    return context();
+  }
+
   void *to_virt();
 
   [[gnu::unused]] std::string to_string();
 
-  static void initialize(volatile char *start_address);
-
   [[nodiscard]] std::string to_string_compact() const;
 
   [[nodiscard]] void *to_virt() const;
 
-  [[nodiscard]] DRAMAddr add(size_t bank_increment, size_t row_increment, size_t column_increment) const;
+  /// Computes the bank, row, and column of this address in the whole DRAM rather than relative to its superpage (see
+  /// TranslationContext), which only differ for wide mappings. Returns false if the physical address is unknown.
+  bool get_absolute(size_t &abs_bank, size_t &abs_row, size_t &abs_col) const;
 
-  void add_inplace(size_t bank_increment, size_t row_increment, size_t column_increment);
+  /// Returns the channel, DIMM (within the channel), rank (within the DIMM), and bank group of this address as
+  /// labelled in the config, or 0 for parts that are not labelled. They are taken from the absolute bank if it is known
+  /// (see get_absolute), otherwise from the bank within the superpage.
+  [[nodiscard]] size_t get_channel() const;
 
-  static size_t get_bank_count() {
-    if (Config == NULL) {
-      throw std::logic_error("Config not yet initialized");
-    }
-    return 1ULL << __builtin_popcountl(MemConfig.BK_MASK);
-  }
+  [[nodiscard]] size_t get_dimm() const;
 
-  static size_t get_row_count() {
-    if (Config == NULL) {
-      throw std::logic_error("Config not yet initialized");
-    }
+  [[nodiscard]] size_t get_rank() const;
 
-    size_t row_count = 1ULL << __builtin_popcountl(MemConfig.ROW_MASK);
-    return row_count;
-  }
+  [[nodiscard]] size_t get_bank_group() const;
 
-#ifdef ENABLE_JSON
-  static nlohmann::json get_memcfg_json();
-#endif
+  /// Returns a name of the DIMM of this address (e.g., "channel 1, DIMM 0") for reporting results per DIMM.
+  [[nodiscard]] std::string get_dimm_name() const;
+
+  [[nodiscard]] DRAMAddr add(size_t bank_increment, size_t row_increment, size_t column_increment) const;
+
+  void add_inplace(size_t bank_increment, size_t row_increment, size_t column_increment);
+
+  /// Appends the addresses of all cache lines that belong to the DRAM row of this address (i.e., the same superpage,
+  /// bank, and row) to lines, in no particular order.
+  void get_row_lines(std::vector<volatile char *> &lines) const;
+
+  /// Translates the n virtual addresses in addrs, which must belong to the region of ctx, to DRAM addresses, stored in
+  /// out.
+  static void from_virt_batch(const TranslationContext &ctx, volatile char *const *addrs, size_t n, DRAMAddr *out);
 
+  /// Translates the n DRAM addresses in addrs, which must all have been created with ctx, to virtual addresses, stored
+  /// in out.
+  static void to_virt_batch(const TranslationContext &ctx, const DRAMAddr *addrs, size_t n, volatile char **out);
 };
 
 #ifdef ENABLE_JSON
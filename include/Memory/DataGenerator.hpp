@@ -0,0 +1,49 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_DATAGENERATOR_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_DATAGENERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// A stateless, counter-based generator for the expected memory contents: the 64-bit word at any offset is a hash of
+// the offset and the run's seed, so it can be computed in O(1) for any address, by any thread and in any order.
+class DataGenerator {
+ private:
+  typedef void (*fill_fn)(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal);
+
+  // the fill kernel selected for this CPU, resolved during static initialization (i.e., before any thread can use it)
+  static const fill_fn fill_kernel;
+
+  static fill_fn select_kernel();
+
+  static void fill_scalar(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal);
+
+  static void fill_avx2(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal);
+
+  static void fill_avx512(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal);
+
+ public:
+  uint64_t seed = 0;
+
+  DataGenerator() = default;
+
+  explicit DataGenerator(uint64_t seed);
+
+  /// Returns the expected 64-bit word at the given byte offset, which must be a multiple of sizeof(uint64_t).
+  [[nodiscard]] inline uint64_t word_at(uint64_t offset) const {
+    return hash(seed, offset/sizeof(uint64_t));
+  }
+
+  /// Writes the expected contents of [offset, offset+len) to dst. Both offset and len must be multiples of 64. If
+  /// non_temporal is set, dst must be 64-byte aligned and is written with streaming stores that bypass the caches.
+  void fill(uint64_t offset, char *dst, size_t len, bool non_temporal = false) const;
+
+  /// The splitmix64 finalizer applied to the word index, keyed by the seed.
+  static inline uint64_t hash(uint64_t seed, uint64_t index) {
+    uint64_t z = seed ^ (index*0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30U))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U))*0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_DATAGENERATOR_HPP_
@@ -11,11 +11,15 @@
 #include <random>
 
 #include "Utilities/AsmPrimitives.hpp"
-#include "Utilities/BlacksmithConfig.hpp"
+#include "Memory/CalibrationCache.hpp"
+#include "Memory/DRAMAddr.hpp"
+#include "Memory/RefreshProfiler.hpp"
+#include "Utilities/ThresholdCalibrator.hpp"
 
 class DramAnalyzer {
  private:
-  BlacksmithConfig &config;
+  // the address mapping and location of the memory area that is analyzed
+  const TranslationContext &ctx;
 
   volatile char *start_address;
 
@@ -23,19 +27,99 @@ class DramAnalyzer {
 
   std::uniform_int_distribution<int> dist;
 
-  #define THRESH_SAMPLES 10000
-
-  //Determine the number of clock ticks which differentiates between a row hit and a row miss
-  static size_t determine_conflict_thresh(volatile char *base, volatile char *diff, volatile char *same);
-
-  // Check the correctness of the memory mapping function in the config
-  static void check_addr_function(size_t thresh);
-
-  // Determine the number of possible activations within a refresh interval.
-  static size_t count_acts_per_trefi(volatile char *base, volatile char *diff, size_t start_threshold);
+  // the number of repetitions each calibration sample averages over
+  static constexpr size_t CALIBRATION_ROUNDS = 100;
+
+  // the number of samples (half of them row hits, half row conflicts) the threshold calibration takes between two
+  // checks whether hits and conflicts are separated, and in total at least and at most
+  static constexpr size_t CALIBRATION_BATCH = 32;
+  static constexpr size_t CALIBRATION_MIN_SAMPLES = 64;
+  static constexpr size_t CALIBRATION_MAX_SAMPLES = 4096;
+
+  // the number of samples each bank's own calibration takes at most, and the relative difference of a bank's mean hit
+  // or conflict latency from the global ones above which the banks get their own thresholds
+  static constexpr size_t BANK_CALIBRATION_MAX_SAMPLES = 128;
+  static constexpr double BANK_TIMING_TOLERANCE = 0.05;
+
+  // the number of clock ticks which differentiates between a row hit and a row conflict, globally and per bank (only
+  // differs from the global one if the banks' timings differ)
+  size_t conflict_threshold = 0;
+  std::vector<size_t> bank_thresholds;
+
+  // times a random pair of addresses in the given bank that is either a row conflict or a row hit
+  uint64_t measure_random_pair(size_t bank, bool conflict);
+
+  // calibrates a threshold from pairs of the given banks (chosen at random), until it separates hits from conflicts
+  // or max_samples were taken; returns whether they were separated
+  bool calibrate(ThresholdCalibrator &calibrator, size_t first_bank, size_t num_banks, size_t max_samples);
+
+  // Determine the number of clock ticks which differentiates between a row hit and a row conflict, for all banks
+  void determine_conflict_thresholds();
+
+  // the mismatch rates (pairs of addresses whose timing contradicts the config) that check_addr_function tells apart:
+  // a correct config still sees occasional timing noise, while a wrong bank or row function affects a large share of
+  // all pairs; each is wrongly accepted with probability CHECK_ERROR_PROB. A single wrong bank function splits half of
+  // the same-bank pairs, which are half of all pairs, i.e., it mismatches about 25% of them, so the wrong rate is well
+  // below that to also refute such a config when part of its mismatches are hidden by noise
+  static constexpr double CHECK_CORRECT_RATE = 0.05;
+  static constexpr double CHECK_WRONG_RATE = 0.15;
+  static constexpr double CHECK_ERROR_PROB = 0.001;
+
+  // the number of address pairs check_addr_function times at least (per bank) and at most before deciding
+  static constexpr size_t CHECK_MIN_PAIRS_PER_BANK = 2;
+  static constexpr size_t CHECK_MAX_PAIRS = 5000;
+
+  // Check the correctness of the memory mapping function in the config by timing random pairs of addresses across all
+  // banks, until a sequential test confirms or refutes the config; returns the share of mismatching pairs
+  double check_addr_function();
+
+  // the number of random address pairs (half of them row hits, half row conflicts) a cached calibration is checked
+  // with before it is reused, and the share of them that may be timed wrongly
+  static constexpr size_t SPOT_CHECK_PAIRS = 64;
+  static constexpr double SPOT_CHECK_MAX_MISMATCHES = 0.1;
+
+  // checks whether the given (cached) thresholds still tell row hits from row conflicts
+  bool spot_check(const Calibration &calibration);
+
+  // the time count_acts_per_trefi may take at most, and the number of accesses between two looks at the clock
+  static constexpr long ACTS_TIME_BUDGET_MS = 1000;
+  static constexpr uint64_t ACTS_CLOCK_CHECK_INTERVAL = 1024;
+
+  // the number of accesses count_acts_per_trefi skips at the start (as the first ones may be slowed down by other
+  // effects), and the number of refresh intervals it measures at least before deciding anything
+  static constexpr uint64_t ACTS_SKIP_ACCESSES = 50;
+  static constexpr size_t ACTS_MIN_INTERVALS = 200;
+
+  // the relative half-width of the 95% confidence interval at which the mean number of activations has converged
+  static constexpr double ACTS_MAX_RELATIVE_CI = 0.01;
+
+  // a mean of at most this many activations means that the threshold also catches accesses not delayed by a refresh,
+  // in which case it is raised by the step (at most the given number of times)
+  static constexpr double ACTS_MIN_PLAUSIBLE = 5;
+  static constexpr size_t ACTS_THRESHOLD_STEP = 10;
+  static constexpr size_t ACTS_MAX_THRESHOLD_STEPS = 20;
+
+  // the number of activations per refresh interval assumed if it cannot be measured and was not measured before;
+  // typical for DDR4 (tREFI of 7.8 us), see FuzzingParameterSet
+  static constexpr size_t ACTS_PER_TREFI_FALLBACK = 100;
+
+  // the number of activations per refresh interval, as last determined
+  size_t acts_per_trefi = 0;
+
+  // records the accesses delayed by refreshes while counting the activations, and the refresh cadence derived from them
+  RefreshProfiler refresh_profiler;
+  RefreshProfile refresh_profile;
+
+  void log_refresh_profile() const;
+
+  // Determine the number of possible activations within a refresh interval, by counting the accesses between two that
+  // are delayed by a refresh, until the mean converges or the time budget runs out. Falls back to the previous value
+  // (or ACTS_PER_TREFI_FALLBACK) if no refreshes could be told apart. Also profiles the refresh cadence from the
+  // timestamps of the delayed accesses.
+  size_t count_acts_per_trefi(volatile char *base, volatile char *diff, size_t start_threshold);
 
  public:
-  explicit DramAnalyzer(BlacksmithConfig &config, volatile char *target);
+  explicit DramAnalyzer(const TranslationContext &ctx);
 
   /// Measures the time between accessing two addresses.
   static inline uint64_t measure_time(volatile char *a1, volatile char *a2, size_t rounds) {
@@ -56,7 +140,24 @@ class DramAnalyzer {
     return sum / rounds;
   }
 
-  size_t analyze_dram(bool check);
+  /// Determines the row conflict thresholds and returns the number of activations per refresh interval; checks the
+  /// config first if check is true. If a cache is given, a calibration stored in it for this system is reused after a
+  /// spot check (unless reuse_cached is false), and a new calibration is stored in it.
+  size_t analyze_dram(bool check, CalibrationCache *cache = nullptr, bool reuse_cached = true);
+
+  /// Measures the number of activations per refresh interval again, reusing the row conflict thresholds (which are
+  /// only determined if analyze_dram has not been called yet). Takes at most about a second.
+  size_t measure_acts_per_trefi();
+
+  /// Returns the refresh cadence observed by the last measurement of the activations per refresh interval.
+  [[nodiscard]] const RefreshProfile &get_refresh_profile() const {
+    return refresh_profile;
+  }
+
+  /// Returns the row conflict threshold of the given bank, as determined by the last call to analyze_dram.
+  [[nodiscard]] size_t get_conflict_threshold(size_t bank) const {
+    return bank < bank_thresholds.size() ? bank_thresholds[bank] : conflict_threshold;
+  }
 };
 
 #endif /* DRAMANALYZER */
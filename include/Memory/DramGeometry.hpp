@@ -0,0 +1,299 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_DRAMGEOMETRY_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_DRAMGEOMETRY_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "GlobalDefines.hpp"
+#include "Memory/DRAMAddr.hpp"
+
+// Lazy ranges over the DRAM geometry of a TranslationContext. None of them allocates: as the address mapping is
+// linear, each iterator derives the next address from the current one with a few XORs instead of translating every
+// DRAMAddr from scratch.
+
+/// The cache lines of a DRAM row, i.e., of the same superpage, bank, and row, in no particular order.
+class RowLines {
+ public:
+  class iterator {
+   private:
+    size_t cur;
+    size_t idx;
+    size_t num_lines;
+    const size_t *basis;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = volatile char *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = volatile char *;
+
+    iterator(size_t cur, size_t idx, size_t num_lines, const size_t *basis)
+        : cur(cur), idx(idx), num_lines(num_lines), basis(basis) {}
+
+    volatile char *operator*() const {
+      return (volatile char *) cur;
+    }
+
+    iterator &operator++() {
+      // walk the span of the row's line basis in Gray code order, so that each step only needs a single XOR
+      if (++idx < num_lines) cur ^= basis[(size_t) __builtin_ctzl(idx)];
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const {
+      return idx==other.idx;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return idx!=other.idx;
+    }
+  };
+
+  explicit RowLines(const DRAMAddr &row)
+      : first_line((size_t) DRAMAddr(row.get_context(), row.bank, row.row, 0, row.page).to_virt()
+                       & ~(CACHELINE_SIZE - 1)),
+        basis(&row.get_context().get_row_line_basis()) {}
+
+  [[nodiscard]] iterator begin() const {
+    return {first_line, 0, size(), basis->data()};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {first_line, size(), size(), basis->data()};
+  }
+
+  [[nodiscard]] size_t size() const {
+    return 1ULL << basis->size();
+  }
+
+ private:
+  size_t first_line;
+  const std::vector<size_t> *basis;
+};
+
+/// The rows first, first + 1, ..., last - 1 of a bank within a superpage, each given by the address of its column 0.
+/// Rows that do not exist (see TranslationContext::get_row_count) are left out.
+class BankRows {
+ public:
+  class iterator {
+   private:
+    const TranslationContext *ctx;
+    size_t bank;
+    size_t page;
+    size_t row;
+    size_t addr;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = volatile char *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = volatile char *;
+
+    iterator(const TranslationContext &ctx, size_t bank, size_t page, size_t row)
+        : ctx(&ctx), bank(bank), page(page), row(row),
+          addr((size_t) DRAMAddr(ctx, bank, std::min(row, ctx.get_row_count() - 1), 0, page).to_virt()) {}
+
+    volatile char *operator*() const {
+      return (volatile char *) addr;
+    }
+
+    iterator &operator++() {
+      // the address of the past-the-end row is never used, and it may not exist
+      if (row + 1 < ctx->get_row_count()) addr ^= ctx->get_row_delta(row, row + 1);
+      row++;
+      return *this;
+    }
+
+    [[nodiscard]] size_t get_row() const {
+      return row;
+    }
+
+    [[nodiscard]] DRAMAddr get_dram_addr() const {
+      return {*ctx, bank, row, 0, page};
+    }
+
+    bool operator==(const iterator &other) const {
+      return row==other.row;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return row!=other.row;
+    }
+  };
+
+  BankRows(const TranslationContext &ctx, size_t bank, size_t page, size_t first, size_t last)
+      : ctx(ctx), bank(bank), page(page), first(std::min(first, ctx.get_row_count())),
+        last(std::max(this->first, std::min(last, ctx.get_row_count()))) {}
+
+  [[nodiscard]] iterator begin() const {
+    return {ctx, bank, page, first};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {ctx, bank, page, last};
+  }
+
+  [[nodiscard]] size_t size() const {
+    return last - first;
+  }
+
+ private:
+  const TranslationContext &ctx;
+  size_t bank;
+  size_t page;
+  size_t first;
+  size_t last;
+};
+
+/// The rows at most radius rows away from a row in the same bank and superpage (e.g., the possible victims of an
+/// aggressor), excluding the row itself.
+class RowNeighborhood {
+ public:
+  class iterator {
+   private:
+    BankRows::iterator it;
+    BankRows::iterator end;
+    size_t center;
+
+    void skip_center() {
+      if (it!=end && it.get_row()==center) ++it;
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = volatile char *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = volatile char *;
+
+    iterator(BankRows::iterator it, BankRows::iterator end, size_t center) : it(it), end(end), center(center) {
+      skip_center();
+    }
+
+    volatile char *operator*() const {
+      return *it;
+    }
+
+    iterator &operator++() {
+      ++it;
+      skip_center();
+      return *this;
+    }
+
+    [[nodiscard]] size_t get_row() const {
+      return it.get_row();
+    }
+
+    [[nodiscard]] DRAMAddr get_dram_addr() const {
+      return it.get_dram_addr();
+    }
+
+    bool operator==(const iterator &other) const {
+      return it==other.it;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return it!=other.it;
+    }
+  };
+
+  RowNeighborhood(const DRAMAddr &center, size_t radius)
+      : rows(center.get_context(), center.bank, center.page, center.row - std::min(center.row, radius),
+             center.row + radius + 1),
+        center(center.row) {}
+
+  [[nodiscard]] iterator begin() const {
+    return {rows.begin(), rows.end(), center};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {rows.end(), rows.end(), center};
+  }
+
+ private:
+  BankRows rows;
+  size_t center;
+};
+
+/// A fixed number of pseudorandom rows of a bank within a superpage, each given by the address of its column 0. The
+/// rows are drawn uniformly from [min_row, max_row] and then reduced modulo row_modulus, and iterating the range again
+/// yields the same rows. Each dereference translates a row from scratch, so a range that is iterated many times (e.g.,
+/// in a timed loop) should be copied into a vector first.
+class RandomBankRows {
+ public:
+  class iterator {
+   private:
+    const RandomBankRows *range;
+    size_t idx;
+    uint64_t state;
+
+    [[nodiscard]] uint64_t next_random() const {
+      // splitmix64, which is good enough for picking rows and needs no state besides a counter
+      uint64_t z = state + 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = volatile char *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = volatile char *;
+
+    iterator(const RandomBankRows *range, size_t idx) : range(range), idx(idx), state(range->seed) {}
+
+    volatile char *operator*() const {
+      const size_t row = (range->min_row + next_random()%range->num_candidates)%range->row_modulus;
+      return (volatile char *) DRAMAddr(range->ctx, range->bank, row, 0, range->page).to_virt();
+    }
+
+    iterator &operator++() {
+      ++idx;
+      state += 0x9E3779B97F4A7C15ULL;
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const {
+      return idx==other.idx;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return idx!=other.idx;
+    }
+  };
+
+  RandomBankRows(const TranslationContext &ctx, size_t bank, size_t page, size_t min_row, size_t max_row,
+                 size_t row_modulus, size_t count, uint64_t seed)
+      : ctx(ctx), bank(bank), page(page), min_row(min_row), num_candidates(std::max(max_row, min_row) - min_row + 1),
+        row_modulus(std::max(std::min(row_modulus, ctx.get_row_count()), (size_t) 1)), count(count), seed(seed) {}
+
+  [[nodiscard]] iterator begin() const {
+    return {this, 0};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {this, count};
+  }
+
+  [[nodiscard]] size_t size() const {
+    return count;
+  }
+
+ private:
+  const TranslationContext &ctx;
+  size_t bank;
+  size_t page;
+  size_t min_row;
+  size_t num_candidates;
+  size_t row_modulus;
+  size_t count;
+  uint64_t seed;
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_DRAMGEOMETRY_HPP_
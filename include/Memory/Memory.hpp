@@ -8,55 +8,126 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <optional>
 #include <string>
 
+#include "Memory/DataGenerator.hpp"
 #include "Memory/DramAnalyzer.hpp"
+#include "Memory/RowLedger.hpp"
 #include "Fuzzer/PatternAddressMapper.hpp"
 
-enum class DATA_PATTERN : char {
-  ZEROES, ONES, RANDOM
-};
-
 class Memory {
  private:
-  /// the starting address of the allocated memory area
-  /// this is a fixed value as the assumption is that all memory cells are equally vulnerable
-  volatile char *start_address = (volatile char *) 0x2000000000;
+  /// the starting address of the memory area, given by the translation context
+  volatile char *start_address;
 
   // the mount point of the huge pages filesystem
-  const std::string hugetlbfs_mountpoint = "/mnt/huge/buff";
+  static constexpr const char *hugetlbfs_mountpoint = "/mnt/huge/buff";
 
-  BlacksmithConfig &config;
+  // the address mapping and location of the memory area
+  const TranslationContext &ctx;
 
   // the size of the allocated memory area in bytes
   uint64_t size;
 
-  // whether this memory allocation is backed up by a superage
-  const bool superpage;
+  // whether rows are only initialized when a mapping uses them for the first time instead of at allocation
+  const bool lazy_init;
+
+  // generates the (reproducible) values the memory is initialized with
+  DataGenerator generator;
+
+  // tracks which rows were hammered, verified, and restored
+  RowLedger ledger;
+
+  // the aggressor rows of the mapping that is probed, needed to determine the contents of AGGRESSOR_INVERSE rows
+  std::vector<DRAMAddr> pattern_aggressors;
+
+  // writes the expected values back to all cache lines of the given row and marks it as initialized
+  void restore_row(const DRAMAddr &row);
+
+  // collects the (canonical) aggressor and victim rows of the mapping
+  void get_mapping_rows(PatternAddressMapper &mapping, std::vector<DRAMAddr> &aggressors,
+                               std::vector<DRAMAddr> &victims);
+
+  // returns the value of every byte of the given row for a data pattern other than RANDOM
+  [[nodiscard]] uint8_t get_pattern_byte(DATA_PATTERN data_pattern, const DRAMAddr &row) const;
+
+  // writes the expected contents of [offset, offset+len) for the given data pattern to dst
+  void fill_expected(DATA_PATTERN data_pattern, uint64_t offset, char *dst, size_t len) const;
+
+  // writes the mapping's data pattern to its aggressor and victim rows
+  void apply_data_pattern(PatternAddressMapper &mapping);
+
+  // computes the digest of the given lines' current contents, or of their expected (random) contents if expected is set
+  uint32_t get_row_digest(const RowLines &lines, bool expected) const;
+
+  // computes the digests of all rows' expected contents, called after initializing the memory with random data
+  void build_row_digests();
+
+  // initializes the pages in [start_offset, end_offset) relative to start_address, called by the worker threads
+  void initialize_range(DATA_PATTERN data_pattern, uint64_t start_offset, uint64_t end_offset);
 
   size_t check_memory_internal(PatternAddressMapper &mapping, const volatile char *start,
                                const volatile char *end, bool reproducibility_mode, bool verbose);
 
+  // checks the given (sorted) cache lines for bit flips
+  size_t check_lines(PatternAddressMapper &mapping, const std::vector<volatile char *> &lines,
+                     bool reproducibility_mode, bool verbose);
+
+  // compares a single cache line byte-by-byte with its expected contents, records and restores any flipped bits
+  size_t extract_bitflips(PatternAddressMapper &mapping, volatile char *line, const char *expected_line,
+                          bool reproducibility_mode, bool verbose);
+
  public:
   [[nodiscard]] uint64_t get_size() const;
 
+  [[nodiscard]] uint64_t get_seed() const;
+
+  [[nodiscard]] size_t get_num_pages() const;
+
   // the flipped bits detected during the last call to check_memory
   std::vector<BitFlip> flipped_bits;
 
-  Memory(BlacksmithConfig &config, bool use_superpage);
+  /// the default start address of the memory area
+  /// this is a fixed value as the assumption is that all memory cells are equally vulnerable
+  static constexpr uintptr_t DEFAULT_START_ADDRESS = 0x2000000000;
+
+  /// Creates the memory area described by ctx, which must outlive this object. The area must have been mapped by
+  /// map_superpages, it is unmapped when this object is destroyed. Its data is generated from the given seed, or from a
+  /// random one if no seed is given.
+  Memory(const TranslationContext &ctx, std::optional<uint64_t> seed, bool lazy_init);
 
   ~Memory();
 
+  /// Takes over the memory area mapped at the context's start address and initializes it (unless lazy_init is set).
   void allocate_memory();
 
+  /// Maps num_pages virtually contiguous superpages, using super or huge pages, preferably at start_address. Returns
+  /// the address they were mapped at, which is aligned to HUGEPAGE_SIZE. Exits on failure.
+  static volatile char *map_superpages(volatile char *start_address, size_t num_pages, bool superpage);
+
   void initialize(DATA_PATTERN data_pattern);
 
   size_t check_memory(const volatile char *start, const volatile char *end);
 
+  // initializes the aggressor and victim rows of the mapping that were not initialized yet (only if lazy_init is set)
+  void initialize_rows(PatternAddressMapper &mapping);
+
+  // initializes the mapping's rows, restores rows left dirty by earlier probes, records the mapping's victims as
+  // hammered by a new probe, and writes the mapping's data pattern; must be called before hammering the mapping
+  void prepare_probe(PatternAddressMapper &mapping);
+
   size_t check_memory(PatternAddressMapper &mapping, bool reproducibility_mode, bool verbose);
 
+  // compares all cache lines of the given row with their expected contents, appends any bit flips to flips and
+  // restores the row; rows that were not initialized yet are skipped; unlike check_memory this does not log and does
+  // not modify the ledger, so that it can be called by a background thread while no hammering takes place
+  size_t scrub_row(const DRAMAddr &row, std::vector<BitFlip> &flips);
+
   [[nodiscard]] volatile char *get_starting_address() const;
 
+  [[nodiscard]] const TranslationContext &get_context() const;
+
   std::string get_flipped_rows_text_repr();
 };
 
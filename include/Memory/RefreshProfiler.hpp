@@ -0,0 +1,98 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_REFRESHPROFILER_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_REFRESHPROFILER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// The refresh cadence of the DRAM, as observed from the accesses that were delayed by a refresh.
+struct RefreshProfile {
+  // the width (in ns) and number of the bins of the interval histogram; longer intervals are counted in the last bin
+  static constexpr double HISTOGRAM_BIN_NS = 250;
+  static constexpr size_t HISTOGRAM_BINS = 64;
+
+  // the refresh interval (tREFI) in ns, 0 if it could not be determined
+  double trefi_ns = 0;
+
+  // the standard deviation (in ns) of the refreshes' arrival times around a strictly periodic schedule
+  double jitter_ns = 0;
+
+  // the share of delayed accesses that arrived on the periodic schedule; the others were delayed by something else
+  // (e.g., interrupts) or the schedule is not periodic
+  double phase_stability = 0;
+
+  // whether the refresh interval is half of DDR4's nominal one, as memory controllers do at high temperatures
+  bool double_refresh = false;
+
+  // the frequency of the time stamp counter the timestamps were converted with
+  double tsc_ghz = 0;
+
+  // the number of delayed accesses the profile is based on
+  size_t num_delays = 0;
+
+  // the number of intervals between consecutive delayed accesses, in bins of HISTOGRAM_BIN_NS; analyze only takes the
+  // first estimate of the interval from it and fits the fields above to the timestamps, so once the profile has been
+  // analyzed it is only for diagnosis (it is logged and cached with the calibration, but nothing reads it back)
+  std::vector<size_t> interval_histogram;
+
+  [[nodiscard]] bool is_valid() const {
+    return trefi_ns > 0;
+  }
+
+  /// Returns the non-empty bins of the histogram as "[from-to us]: count, ...".
+  [[nodiscard]] std::string get_histogram_text() const;
+};
+
+void to_json(nlohmann::json &j, const RefreshProfile &p);
+
+void from_json(const nlohmann::json &j, RefreshProfile &p);
+
+// Records the time stamp counter (TSC) values of accesses delayed by a refresh in a ring buffer, and derives the
+// refresh interval and its stability from them. Delays that are not caused by refreshes (e.g., interrupts) and
+// refreshes that were missed are tolerated, as each delay is assigned to the nearest refresh of a periodic schedule.
+class RefreshProfiler {
+ public:
+  // DDR4's nominal refresh interval, which halves with 2x refresh
+  static constexpr double NOMINAL_TREFI_NS = 7800;
+
+ private:
+  // the minimal number of delays and share of them on the schedule for a valid profile
+  static constexpr size_t MIN_DELAYS = 64;
+  static constexpr double MIN_PHASE_STABILITY = 0.5;
+
+  // delays further than this share of the refresh interval from the schedule are not on it
+  static constexpr double MAX_PHASE_DEVIATION = 0.25;
+
+  // a delay that follows the previous one by a multiple of the refresh interval (up to this share of it) is taken as
+  // caused by a refresh when numbering the refreshes
+  static constexpr double ANCHOR_DEVIATION = 0.1;
+
+  std::vector<uint64_t> timestamps;
+
+  // the index the next timestamp is written to, and the number of timestamps recorded since the last clear
+  size_t next = 0;
+  size_t count = 0;
+
+ public:
+  explicit RefreshProfiler(size_t capacity = 4096);
+
+  /// Records the TSC value of a delayed access, overwriting the oldest one if the buffer is full.
+  void record(uint64_t tsc) {
+    timestamps[next] = tsc;
+    next = (next + 1)%timestamps.size();
+    count++;
+  }
+
+  void clear() {
+    next = 0;
+    count = 0;
+  }
+
+  /// Derives the refresh profile from the recorded timestamps, given the TSC frequency in ticks per ns.
+  [[nodiscard]] RefreshProfile analyze(double tsc_per_ns) const;
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_REFRESHPROFILER_HPP_
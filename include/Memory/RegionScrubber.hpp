@@ -0,0 +1,90 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_REGIONSCRUBBER_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_REGIONSCRUBBER_HPP_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Memory/Memory.hpp"
+
+// A low-priority background thread that sweeps over all rows of the memory pool while no hammering takes place, to
+// find bit flips that check_memory cannot see because they are outside of the victim window of the hammered mapping
+// (e.g., far away from the aggressors or in another bank due to an incorrect address mapping). Found bit flips are
+// attributed to the mapping hammered last.
+class RegionScrubber {
+ private:
+  Memory &memory;
+
+  // the maximum throughput of the scrubber in bytes per second
+  const double rate_bytes_per_sec;
+
+  std::thread worker;
+
+  // protects all members below
+  std::mutex mtx;
+
+  std::condition_variable cv;
+
+  bool running = false;
+
+  bool paused = false;
+
+  // whether the worker is currently scrubbing a row, pause waits for this to become false
+  bool busy = false;
+
+  // the ID of the mapping that was hammered last
+  std::string mapping_id;
+
+  // the bit flips found since the last call to report_bitflips
+  std::vector<BitFlip> pending_flips;
+
+  // the mapping that was hammered last when each of the pending bit flips was found
+  std::vector<std::string> pending_mapping_ids;
+
+  // maps (mapping_id) -> (number of bit flips found outside of this mapping's victim window)
+  std::unordered_map<std::string, size_t> flips_per_mapping;
+
+  size_t total_flips = 0;
+
+  size_t completed_sweeps = 0;
+
+  // the next row to be scrubbed
+  size_t next_page = 0;
+  size_t next_bank = 0;
+  size_t next_row = 0;
+
+  void run();
+
+  // returns the row to scrub next and advances to the following one
+  DRAMAddr advance();
+
+ public:
+  RegionScrubber(Memory &memory, size_t rate_mib_per_sec);
+
+  ~RegionScrubber();
+
+  /// Starts the worker thread on a CPU that does not share a physical core with the calling (i.e., hammering) thread.
+  void start();
+
+  /// Stops and joins the worker thread.
+  void stop();
+
+  /// Blocks until the worker finished the row it is scrubbing, it does not touch the memory until resume is called.
+  void pause();
+
+  void resume();
+
+  /// Sets the mapping that bit flips found from now on are attributed to.
+  void set_mapping(const std::string &id);
+
+  /// Logs the bit flips found since the last call and returns their number of corrupted bits. Must be called from the
+  /// main thread as the Logger is not thread-safe.
+  size_t report_bitflips();
+
+  [[nodiscard]] size_t get_total_flips();
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_REGIONSCRUBBER_HPP_
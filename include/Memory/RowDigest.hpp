@@ -0,0 +1,36 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_ROWDIGEST_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_ROWDIGEST_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+// Computes CRC32C digests of memory contents, used to check whether a row still holds its expected contents by
+// comparing a single word instead of all of its data. CRC32C detects every corruption of up to three bits in a row.
+class RowDigest {
+ private:
+  typedef uint32_t (*crc_fn)(uint32_t crc, const volatile char *data, size_t len);
+
+  // the CRC kernel selected for this CPU, resolved during static initialization (i.e., before any thread can use it)
+  static const crc_fn crc_kernel;
+
+  // lookup table of the scalar kernel (reflected Castagnoli polynomial), built during static initialization
+  static const uint32_t *const crc_table;
+
+  static crc_fn select_kernel();
+
+  static const uint32_t *build_table();
+
+  static uint32_t crc32c_scalar(uint32_t crc, const volatile char *data, size_t len);
+
+  static uint32_t crc32c_sse42(uint32_t crc, const volatile char *data, size_t len);
+
+ public:
+  /// Continues the CRC32C computation of crc over len bytes at data, len must be a multiple of 8. Start a new digest
+  /// with crc = 0.
+  static uint32_t crc32c(uint32_t crc, const volatile char *data, size_t len);
+
+  /// Returns the name of the CRC kernel used on this CPU (e.g., for logging).
+  static const char *get_kernel_name();
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_ROWDIGEST_HPP_
@@ -0,0 +1,87 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_ROWLEDGER_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_ROWLEDGER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Memory/DRAMAddr.hpp"
+
+enum ROW_STATE : uint8_t {
+  // the row was a victim of the hammering
+  HAMMERED = 1U << 0U,
+  // the row was checked for bit flips after it has been hammered
+  VERIFIED = 1U << 1U,
+  // bit flips were found in the row and its original contents were written back
+  RESTORED = 1U << 2U,
+  // the row holds its expected contents, i.e., it was initialized (see Memory::initialize_rows)
+  INITIALIZED = 1U << 3U,
+  // the digest of the row's expected contents is known
+  HAS_DIGEST = 1U << 4U
+};
+
+// Keeps track of the state of every DRAM row in the memory pool across probes, so that rows which were hammered but
+// never verified can be restored before the next probe instead of re-initializing the whole memory, and rows that were
+// never initialized (lazy initialization) are known.
+class RowLedger {
+ private:
+  // the context of the memory pool, used to create the DRAMAddr of a row
+  const TranslationContext *ctx = nullptr;
+
+  size_t num_banks = 0;
+
+  size_t num_rows = 0;
+
+  // ROW_STATE flags of each row
+  std::vector<uint8_t> states;
+
+  // the digest of each row's expected contents (see RowDigest), valid if HAS_DIGEST is set
+  std::vector<uint32_t> digests;
+
+  // indices of the rows marked as hammered since the last call to take_dirty_rows
+  std::vector<size_t> hammered_rows;
+
+  // returns the index of the row, or size() if it is not tracked (e.g., an aggressor shifted beyond the last row),
+  // which must not be aliased onto the state of another row
+  [[nodiscard]] size_t index_of(const DRAMAddr &addr) const;
+
+  // returns the index of the row to update, or size() after logging an error if it is not tracked
+  size_t index_to_update(const DRAMAddr &addr, const char *update) const;
+
+ public:
+  /// Tracks all rows of the region of the given context, which must outlive the ledger. Resets the state of all rows.
+  void resize(const TranslationContext &ctx);
+
+  /// Returns the number of rows tracked by the ledger.
+  [[nodiscard]] size_t size() const;
+
+  /// Returns the row with the given index, i.e., 0 <= index < size().
+  [[nodiscard]] DRAMAddr row_at(size_t index) const;
+
+  /// Returns whether the row is tracked, i.e., within the banks, rows, and superpages of the context. The state of
+  /// other rows is never updated (the marks log an error) and unknown (is_initialized and get_digest return false).
+  [[nodiscard]] bool contains(const DRAMAddr &addr) const;
+
+  void mark_hammered(const DRAMAddr &addr);
+
+  void mark_verified(const DRAMAddr &addr);
+
+  void mark_restored(const DRAMAddr &addr);
+
+  void mark_initialized(const DRAMAddr &addr);
+
+  void mark_all_initialized();
+
+  [[nodiscard]] bool is_initialized(const DRAMAddr &addr) const;
+
+  void set_digest(const DRAMAddr &addr, uint32_t digest);
+
+  /// Returns true and sets digest iff the digest of the row's expected contents is known.
+  bool get_digest(const DRAMAddr &addr, uint32_t &digest) const;
+
+  /// Returns the rows that were hammered but not verified afterwards, i.e., may still contain bit flips. The caller is
+  /// expected to restore these rows, they are marked as verified and not returned again.
+  std::vector<DRAMAddr> take_dirty_rows();
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_ROWLEDGER_HPP_
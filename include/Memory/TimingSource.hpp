@@ -0,0 +1,69 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_TIMINGSOURCE_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_TIMINGSOURCE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "Memory/TranslationContext.hpp"
+
+// Where ConfigDiscovery gets the access times of address pairs from: real DRAM, or a synthetic oracle that answers
+// from a known mapping, so that the discovery can be tested without superpages or any particular DRAM.
+class TimingSource {
+ public:
+  virtual ~TimingSource() = default;
+
+  /// Returns the time of accessing both addresses, in the unit of DramAnalyzer::measure_time.
+  virtual uint64_t measure(volatile char *a, volatile char *b) = 0;
+};
+
+// Times the accesses with DramAnalyzer::measure_time, i.e., on the memory the addresses point to.
+class DramTimingSource : public TimingSource {
+ private:
+  // the number of repetitions each measurement averages over
+  size_t rounds;
+
+ public:
+  explicit DramTimingSource(size_t rounds);
+
+  uint64_t measure(volatile char *a, volatile char *b) override;
+};
+
+// Answers like DRAM with the given mapping would, without accessing memory: an address pair in the same bank but
+// different rows takes CONFLICT_TIME, any other pair HIT_TIME, both with normally distributed noise, and a share of
+// the measurements is disturbed by an outlier (e.g., an interrupt) that makes it look like a conflict.
+class SyntheticTimingSource : public TimingSource {
+ private:
+  static constexpr double HIT_TIME = 250;
+  static constexpr double CONFLICT_TIME = 330;
+  static constexpr double NOISE_STD = 12;
+  static constexpr double OUTLIER_TIME = 400;
+
+  MemConfiguration mem_config;
+
+  // the superpage the addresses are in, only their offsets within it are translated
+  volatile char *superpage;
+
+  std::mt19937_64 gen;
+
+  std::normal_distribution<double> noise{0, NOISE_STD};
+
+  std::bernoulli_distribution outlier;
+
+  size_t num_measurements = 0;
+
+  // returns the bank (first) and row (second) of the offset of the address within the superpage
+  [[nodiscard]] std::pair<size_t, size_t> to_bank_row(volatile char *addr) const;
+
+ public:
+  SyntheticTimingSource(const MemConfiguration &mem_config, volatile char *superpage, uint64_t seed,
+                        double outlier_rate = 0.01);
+
+  uint64_t measure(volatile char *a, volatile char *b) override;
+
+  [[nodiscard]] size_t get_num_measurements() const {
+    return num_measurements;
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_TIMINGSOURCE_HPP_
@@ -0,0 +1,295 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_TRANSLATIONCONTEXT_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_TRANSLATIONCONTEXT_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef ENABLE_JSON
+#include <nlohmann/json.hpp>
+#endif
+
+#include "Utilities/BlacksmithConfig.hpp"
+
+// the maximum number of bits of an address mapping
+#define MAX_MTX_SIZE (64U)
+
+// the number of address bits within a superpage (see HUGEPAGE_SIZE); mappings of this width only depend on the offset
+// within a superpage, wider mappings also on the physical location of the superpage
+#define SUPERPAGE_BITS (30U)
+
+struct MemConfiguration {
+  // the number of bits of the mapping, i.e., the number of rows of both matrices that are used
+  size_t WIDTH;
+  size_t BK_SHIFT;
+  size_t BK_MASK;
+  size_t ROW_SHIFT;
+  size_t ROW_MASK;
+  size_t COL_SHIFT;
+  size_t COL_MASK;
+  // row r of a matrix (r < WIDTH) computes bit WIDTH-1-r of the product
+  std::array<size_t, MAX_MTX_SIZE> DRAM_MTX;
+  std::array<size_t, MAX_MTX_SIZE> ADDR_MTX;
+};
+
+// the parts of a bank that the bank functions of a config can be labelled with (see BlacksmithConfig)
+enum class BankLabel : size_t {
+  CHANNEL = 0, DIMM = 1, RANK = 2, BANK_GROUP = 3
+};
+
+// Everything needed to translate between the virtual addresses of a memory region and DRAM addresses: the address
+// mapping of a config and the location of the region. A context never changes after it has been constructed, hence
+// any number of contexts (e.g., for regions on different NUMA nodes with different mappings) can be used concurrently
+// from any thread without locking.
+//
+// Mappings can be wider than a superpage (SUPERPAGE_BITS), e.g., if channel, DIMM, or rank bits are above bit 30. As
+// the mapping is linear, the DRAM address of an address in superpage p is the DRAM address of its offset within the
+// superpage XORed with the DRAM address of p's physical base address (its origin). DRAMAddr stores the former, which
+// is all that is needed to navigate within a superpage; the absolute DRAM address is available via the origin. Bank
+// functions of physical bits above the superpage only (e.g., a channel selected by bit 33) are constant within a
+// superpage, so DRAMAddr::bank only counts the banks reachable within it and the origin supplies the remaining bits.
+class TranslationContext {
+ private:
+  BlacksmithConfig config;
+
+  MemConfiguration mem_config;
+
+  // the first byte of the region
+  volatile char *start_address;
+
+  // the higher order bits above the region's first superpage
+  size_t base_msb;
+
+  // the number of (virtually contiguous) superpages of the region
+  size_t num_pages;
+
+  // the number of rows of a bank within a superpage, i.e., the rows that DRAMAddr::row can refer to
+  size_t rows_per_page = 0;
+
+  // the bits of the bank part of a linearized DRAM address (see MemConfiguration::BK_MASK) that depend on the offset
+  // within a superpage, the others only depend on its origin
+  size_t local_bank_mask = 0;
+
+  // for each BankLabel, the positions of the bits of a bank (see DRAMAddr::bank) that select it, most significant first
+  std::array<std::vector<size_t>, 4> label_bits;
+
+  // the positions of the bits of a bank in the order in which spread_bank assigns the bits of a counter to them
+  std::vector<size_t> spread_order;
+
+  // the positions of the bank bits that only depend on the superpage's origin, in the same order; spread_page
+  // alternates between their values instead
+  std::vector<size_t> origin_spread_order;
+
+  // the superpages in the order in which spread_page returns them
+  std::vector<size_t> page_order;
+
+  // the value each bit of a row number XORs into the address of a row (of any bank and column), see get_row_delta
+  std::vector<size_t> row_bit_offsets;
+
+  // a basis of the cache line offsets spanned by the columns of a row, see DRAMAddr::get_row_lines
+  std::vector<size_t> row_line_basis;
+
+  // the matrices restricted to offsets within a superpage: DRAM_MTX ignoring all bits of the physical superpage and
+  // ADDR_MTX computing only the offset bits; the lookup tables and blocks below are built from these
+  std::array<size_t, MAX_MTX_SIZE> local_dram_mtx{};
+  std::array<size_t, MAX_MTX_SIZE> local_addr_mtx{};
+
+  // byte-sliced lookup tables of the matrices: a matrix-vector product over GF(2) is the XOR of the products with
+  // each byte of the vector, which are precomputed for all 256 values of each byte position
+  typedef std::array<std::array<size_t, 256>, sizeof(size_t)> matrix_lut;
+  matrix_lut dram_lut{};
+  matrix_lut addr_lut{};
+
+  // the number of byte positions covered by the lookup tables, higher bytes are ignored by both matrices
+  size_t lut_slices = 0;
+
+  // the 8x8 bit blocks of DRAM_MTX and ADDR_MTX in the matrix format of GFNI's affine transformation, indexed by
+  // [output byte][input byte]; only used if the CPU supports GFNI (see select_batch_kernel)
+  typedef std::array<std::array<uint64_t, sizeof(size_t)>, sizeof(size_t)> matrix_blocks;
+  matrix_blocks dram_blocks{};
+  matrix_blocks addr_blocks{};
+
+  // whether the batch functions use the GFNI kernel instead of the lookup tables
+  bool use_gfni = false;
+
+  // translators specialized for the matrices of a config shipped in config/ (see BuiltinMappings.hpp), or nullptr if
+  // the matrices are not known at compile time and the lookup tables must be used
+  size_t (*builtin_to_dram)(size_t) = nullptr;
+  size_t (*builtin_to_addr)(size_t) = nullptr;
+
+  // restricts the matrices to offsets within a superpage and checks that every bank of local_bank_mask, column, and the
+  // rows_per_page first rows of each bank can be reached within a superpage
+  void build_local_matrices();
+
+  void build_luts();
+
+  void build_blocks(const std::array<size_t, MAX_MTX_SIZE> &mtx, matrix_blocks &blocks) const;
+
+  // selects the GFNI kernel if the CPU supports it and it computes the same results as the lookup tables
+  void select_batch_kernel();
+
+  void select_builtin_mapping();
+
+  void compute_row_line_basis();
+
+  void compute_row_bit_offsets();
+
+  // converts the labels of the config to bit positions and checks them
+  void build_bank_labels();
+
+  // orders the superpages by the bank bits their origins select, see spread_page
+  void build_page_order();
+
+  // multiplies the n vectors in `in' with the matrix given by lut/blocks, stores the products in out
+  void transform(const matrix_lut &lut, const matrix_blocks &blocks, const size_t *in, size_t *out, size_t n) const;
+
+  void transform_gfni(const matrix_blocks &blocks, const size_t *in, size_t *out, size_t n) const;
+
+  // computes the product of the matrix and v bit by bit, used to build the lookup tables
+  [[nodiscard]] size_t apply_matrix(const std::array<size_t, MAX_MTX_SIZE> &mtx, size_t v) const;
+
+  inline size_t apply_lut(const matrix_lut &lut, size_t v) const {
+    size_t res = 0;
+    for (size_t s = 0; s < lut_slices; ++s) {
+      res ^= lut[s][(v >> (8*s)) & 0xFFU];
+    }
+    return res;
+  }
+
+ public:
+  /// Creates the context of a region of page_count superpages at start_address, whose addresses are mapped to DRAM
+  /// as defined by config.
+  TranslationContext(const BlacksmithConfig &config, volatile char *start_address, size_t page_count);
+
+  /// Maps a virtual address of the region to the linearized DRAM address (bank, column, and row bits, see
+  /// MemConfiguration) of its offset within its superpage.
+  [[nodiscard]] inline size_t to_dram(size_t addr) const {
+    return builtin_to_dram ? builtin_to_dram(addr) : apply_lut(dram_lut, addr);
+  }
+
+  /// Maps the linearized DRAM address of an offset within a superpage back to the offset.
+  [[nodiscard]] inline size_t to_addr(size_t linear) const {
+    return builtin_to_addr ? builtin_to_addr(linear) : apply_lut(addr_lut, linear);
+  }
+
+  /// Like to_dram and to_addr, but for n values at once.
+  void to_dram_batch(const size_t *in, size_t *out, size_t n) const;
+
+  void to_addr_batch(const size_t *in, size_t *out, size_t n) const;
+
+  /// Returns the name of the kernel used by the batch functions (e.g., for logging).
+  [[nodiscard]] const char *get_batch_kernel_name() const;
+
+  [[nodiscard]] const BlacksmithConfig &get_config() const {
+    return config;
+  }
+
+  [[nodiscard]] const MemConfiguration &get_mem_config() const {
+    return mem_config;
+  }
+
+  [[nodiscard]] volatile char *get_start_address() const {
+    return start_address;
+  }
+
+  [[nodiscard]] size_t get_base_msb() const {
+    return base_msb;
+  }
+
+  [[nodiscard]] const std::vector<size_t> &get_row_line_basis() const {
+    return row_line_basis;
+  }
+
+  /// Returns the number of cache lines in a DRAM row, i.e., the number of lines returned by DRAMAddr::get_row_lines.
+  [[nodiscard]] size_t get_lines_per_row() const {
+    return 1ULL << row_line_basis.size();
+  }
+
+  /// Returns the number of banks that DRAMAddr::bank can refer to, i.e., that are reachable within each superpage.
+  [[nodiscard]] size_t get_bank_count() const {
+    return 1ULL << __builtin_popcountl(local_bank_mask);
+  }
+
+  /// Converts a bank as counted by DRAMAddr::bank to the bank part of a linearized DRAM address, whose bits that only
+  /// depend on the superpage's origin are 0. This is the identity unless some bank functions only depend on physical
+  /// address bits above the superpage.
+  [[nodiscard]] inline size_t expand_bank(size_t bank) const {
+    if (local_bank_mask==mem_config.BK_MASK) return bank;
+    size_t res = 0;
+    size_t i = 0;
+    for (size_t mask = local_bank_mask; mask!=0; mask &= mask - 1, ++i) {
+      res |= ((bank >> i) & 1ULL) << __builtin_ctzl(mask);
+    }
+    return res;
+  }
+
+  /// The inverse of expand_bank, ignores the bits that only depend on the superpage's origin.
+  [[nodiscard]] inline size_t compress_bank(size_t bank_bits) const {
+    if (local_bank_mask==mem_config.BK_MASK) return bank_bits;
+    size_t res = 0;
+    size_t i = 0;
+    for (size_t mask = local_bank_mask; mask!=0; mask &= mask - 1, ++i) {
+      res |= ((bank_bits >> __builtin_ctzl(mask)) & 1ULL) << i;
+    }
+    return res;
+  }
+
+  [[nodiscard]] size_t get_page_count() const {
+    return num_pages;
+  }
+
+  /// Returns the number of rows of a bank that DRAMAddr::row can refer to, i.e., within each superpage.
+  [[nodiscard]] size_t get_row_count() const {
+    return rows_per_page;
+  }
+
+  /// Returns the value the address of row a must be XORed with to get the address of row b, at the same bank and
+  /// column. Both rows must be below get_row_count().
+  [[nodiscard]] inline size_t get_row_delta(size_t a, size_t b) const {
+    size_t delta = 0;
+    for (size_t diff = a ^ b; diff!=0; diff &= diff - 1) {
+      delta ^= row_bit_offsets[(size_t) __builtin_ctzl(diff)];
+    }
+    return delta;
+  }
+
+  /// Returns whether the mapping depends on the physical location of the superpages, see get_page_origin.
+  [[nodiscard]] bool is_wide() const {
+    return mem_config.WIDTH > SUPERPAGE_BITS;
+  }
+
+  /// Returns the linearized DRAM address of the physical base address of the given superpage, which is 0 for mappings
+  /// that are not wide. Returns false if the physical address is unknown (reading it requires root privileges).
+  bool get_page_origin(size_t page, size_t &origin) const;
+
+  /// Returns whether the config labels any of its bank functions.
+  [[nodiscard]] bool has_bank_labels() const;
+
+  /// Extracts the given part (e.g., the rank) from a bank, which is 0 if the config does not label it.
+  [[nodiscard]] size_t get_bank_label(size_t bank, BankLabel label) const;
+
+  /// Returns the number of distinct values of the given part of a bank.
+  [[nodiscard]] size_t get_bank_label_count(BankLabel label) const {
+    return 1ULL << label_bits[(size_t) label].size();
+  }
+
+  /// Maps the i-th step of a rotation over the banks of a superpage (i < get_bank_count()) to a bank, such that
+  /// consecutive steps first alternate between channels, then DIMMs, ranks, and bank groups. Without labels, this is
+  /// the identity.
+  [[nodiscard]] size_t spread_bank(size_t i) const;
+
+  /// Maps the i-th step of a rotation over the superpages (i < get_page_count()) to a superpage. If some bank
+  /// functions only depend on the superpage's origin (e.g., a channel selected by bit 33), consecutive steps alternate
+  /// between their values like spread_bank does within a superpage, as far as the superpages allow. Otherwise, or if
+  /// the physical addresses are unknown, this is the identity.
+  [[nodiscard]] size_t spread_page(size_t i) const {
+    return page_order[i];
+  }
+
+#ifdef ENABLE_JSON
+  [[nodiscard]] nlohmann::json get_memcfg_json() const;
+#endif
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_TRANSLATIONCONTEXT_HPP_
@@ -0,0 +1,34 @@
+#ifndef BLACKSMITH_INCLUDE_MEMORY_VICTIMVERIFIER_HPP_
+#define BLACKSMITH_INCLUDE_MEMORY_VICTIMVERIFIER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "GlobalDefines.hpp"
+
+class VictimVerifier {
+ private:
+  typedef uint64_t (*compare_fn)(const volatile char *actual, const char *expected, size_t num_lines);
+
+  // the comparison kernel selected for this CPU, resolved during static initialization (i.e., before any thread can
+  // use it)
+  static const compare_fn compare_kernel;
+
+  static compare_fn select_kernel();
+
+  static uint64_t compare_lines_scalar(const volatile char *actual, const char *expected, size_t num_lines);
+
+  static uint64_t compare_lines_avx2(const volatile char *actual, const char *expected, size_t num_lines);
+
+  static uint64_t compare_lines_avx512(const volatile char *actual, const char *expected, size_t num_lines);
+
+ public:
+  /// Compares up to 64 consecutive cache lines starting at `actual' with their expected contents. Returns a bitmask
+  /// in which bit i is set iff the i-th cache line differs. Both pointers must be aligned to CACHELINE_SIZE.
+  static uint64_t compare_lines(const volatile char *actual, const char *expected, size_t num_lines);
+
+  /// Returns the name of the comparison kernel used on this CPU (e.g., for logging).
+  static const char *get_kernel_name();
+};
+
+#endif //BLACKSMITH_INCLUDE_MEMORY_VICTIMVERIFIER_HPP_
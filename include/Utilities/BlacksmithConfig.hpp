@@ -5,14 +5,13 @@
 #ifndef BLACKSMITH_BLACKSMITHCONFIG_HPP
 #define BLACKSMITH_BLACKSMITHCONFIG_HPP
 
-class BlacksmithConfig; // forward declaration needed to break include cycle
-
 #include <string>
 #include <vector>
 #include <variant>
-#include "Memory/DRAMAddr.hpp"
 #include "nlohmann/json.hpp"
 
+struct MemConfiguration; // defined in Memory/TranslationContext.hpp, which includes this header
+
 typedef std::variant<uint64_t, std::vector<uint64_t>> BitDef;
 
 // (de-)serialize std::variant, required for BitDef
@@ -49,6 +48,13 @@ public:
    */
   static BlacksmithConfig from_jsonfile(const std::string &filepath);
 
+  /**
+   * Write this config to a JSON file that from_jsonfile can read
+   *
+   * @param filepath path of the JSON config file to (over)write
+   */
+  void to_jsonfile(const std::string &filepath) const;
+
   BlacksmithConfig();
 
   std::string name;
@@ -60,16 +66,25 @@ public:
   std::vector<BitDef> col_bits;
   std::vector<BitDef> bank_bits;
 
+  // optional labels of the bank functions: the indices into bank_bits of the functions that select the channel, DIMM
+  // (within a channel), rank (within a DIMM), and bank group, most significant first; the remaining functions select
+  // the bank within its bank group
+  std::vector<size_t> channel_bits;
+  std::vector<size_t> dimm_bits;
+  std::vector<size_t> rank_bits;
+  std::vector<size_t> bank_group_bits;
+
   /**
-   * Convert a BlacksmithConfig to a MemConfiguration for use in DRAMAddr.
+   * Convert a BlacksmithConfig to a MemConfiguration for use in a TranslationContext.
    *
    * @param config a reference to a BlacksmithConfig
    * @param out a pointer to a MemConfiguration. `out' will be updated with bit definitions from BlacksmithConfig
    */
-  MemConfiguration to_memconfig();
-
-  NLOHMANN_DEFINE_TYPE_INTRUSIVE(BlacksmithConfig, name,
-                                 channels, dimms, ranks, total_banks,
-                                 row_bits, col_bits, bank_bits)
+  [[nodiscard]] MemConfiguration to_memconfig() const;
 };
+
+void to_json(nlohmann::json &j, const BlacksmithConfig &c);
+
+void from_json(const nlohmann::json &j, BlacksmithConfig &c);
+
 #endif //BLACKSMITH_BLACKSMITHCONFIG_HPP
@@ -0,0 +1,35 @@
+#ifndef BLACKSMITH_INCLUDE_UTILITIES_CPUTOPOLOGY_HPP_
+#define BLACKSMITH_INCLUDE_UTILITIES_CPUTOPOLOGY_HPP_
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+class CpuTopology {
+ private:
+  // parses a sysfs CPU list such as "0-3,8,10-11"
+  static std::vector<int> parse_cpu_list(const std::string &list);
+
+ public:
+  /// Returns the NUMA node the page backing the given address resides on, or -1 if it cannot be determined.
+  static int get_numa_node(volatile void *address);
+
+  /// Returns the CPUs this process may run on that belong to the given NUMA node. If the node is unknown (-1) or
+  /// none of its CPUs are usable, all CPUs this process may run on are returned.
+  static std::vector<int> get_node_cpus(int node);
+
+  /// Returns the hardware threads sharing a physical core with the given CPU (including the CPU itself).
+  static std::vector<int> get_core_siblings(int cpu);
+
+  /// Returns the CPU the calling thread is currently running on.
+  static int get_current_cpu();
+
+  /// Pins the given thread to a single CPU, returns false on failure.
+  static bool pin_thread(pthread_t thread, int cpu);
+
+  /// Returns the value of the given field (e.g., "model name" or "microcode") of the first CPU in /proc/cpuinfo, or
+  /// an empty string if there is no such field.
+  static std::string get_cpu_info(const std::string &field);
+};
+
+#endif //BLACKSMITH_INCLUDE_UTILITIES_CPUTOPOLOGY_HPP_
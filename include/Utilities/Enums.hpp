@@ -33,6 +33,23 @@ std::string to_string(FENCING_STRATEGY strategy);
 
 void from_string(const std::string &strategy, FENCING_STRATEGY &dest);
 
+// the data written to the aggressor and victim rows of a mapping before hammering it
+enum class DATA_PATTERN : char {
+  ZEROES, ONES, RANDOM,
+  // rows alternate between all ones and all zeros
+  ROW_STRIPE,
+  // bits alternate between ones and zeros, inverted from one row to the next
+  CHECKERBOARD,
+  // bits alternate between ones and zeros, the same in every row
+  COLUMN_STRIPE,
+  // aggressor rows are all ones, all other rows (i.e., the victims) all zeros
+  AGGRESSOR_INVERSE
+};
+
+std::string to_string(DATA_PATTERN pattern);
+
+void from_string(const std::string &pattern, DATA_PATTERN &dest);
+
 std::vector<std::pair<FLUSHING_STRATEGY, FENCING_STRATEGY>> get_valid_strategies();
 
 [[maybe_unused]] std::pair<FLUSHING_STRATEGY, FENCING_STRATEGY> get_valid_strategy_pair();
@@ -0,0 +1,192 @@
+#ifndef BLACKSMITH_INCLUDE_UTILITIES_GF2MATRIX_HPP_
+#define BLACKSMITH_INCLUDE_UTILITIES_GF2MATRIX_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// A matrix over GF(2) with up to 64 rows and columns, each row packed into a uint64_t whose bit c is the entry of
+// column c. Multiplying with a vector (also packed, bit c is entry c) thus computes output bit r as the parity of the
+// vector masked by row r. All operations are constexpr so that matrices known at compile time (e.g., the builtin
+// mappings) can be processed at compile time.
+class GF2Matrix {
+ public:
+  static constexpr size_t MAX_SIZE = 64;
+
+ private:
+  std::array<uint64_t, MAX_SIZE> rows{};
+  size_t num_rows = 0;
+  size_t num_cols = 0;
+
+  [[nodiscard]] static constexpr uint64_t col_mask(size_t cols) {
+    return (cols >= 64) ? ~0ULL : (1ULL << cols) - 1;
+  }
+
+  [[nodiscard]] static constexpr size_t parity(uint64_t v) {
+    return (size_t) __builtin_parityll(v);
+  }
+
+  // Transforms the rows to reduced row echelon form by Gauss-Jordan elimination, applying the same row operations to
+  // aux. The pivot column of each of the first rank rows is stored in pivots (ascending), the rank is returned.
+  static constexpr size_t eliminate(std::array<uint64_t, MAX_SIZE> &a, std::array<uint64_t, MAX_SIZE> &aux,
+                                    size_t rows, size_t cols, std::array<size_t, MAX_SIZE> &pivots) {
+    size_t rank = 0;
+    for (size_t c = 0; c < cols && rank < rows; ++c) {
+      const uint64_t bit = 1ULL << c;
+      size_t pivot = rank;
+      while (pivot < rows && !(a[pivot] & bit)) ++pivot;
+      if (pivot==rows) continue;
+      // std::swap is not constexpr before C++20
+      const uint64_t a_tmp = a[rank], aux_tmp = aux[rank];
+      a[rank] = a[pivot];
+      aux[rank] = aux[pivot];
+      a[pivot] = a_tmp;
+      aux[pivot] = aux_tmp;
+      for (size_t r = 0; r < rows; ++r) {
+        if (r!=rank && (a[r] & bit)) {
+          a[r] ^= a[rank];
+          aux[r] ^= aux[rank];
+        }
+      }
+      pivots[rank++] = c;
+    }
+    return rank;
+  }
+
+ public:
+  constexpr GF2Matrix() = default;
+
+  /// Creates the zero matrix of the given size, at most MAX_SIZE x MAX_SIZE.
+  constexpr GF2Matrix(size_t num_rows, size_t num_cols) : num_rows(num_rows), num_cols(num_cols) {}
+
+  [[nodiscard]] static constexpr GF2Matrix identity(size_t n) {
+    GF2Matrix m(n, n);
+    for (size_t i = 0; i < n; ++i) m.rows[i] = 1ULL << i;
+    return m;
+  }
+
+  [[nodiscard]] constexpr size_t get_num_rows() const {
+    return num_rows;
+  }
+
+  [[nodiscard]] constexpr size_t get_num_cols() const {
+    return num_cols;
+  }
+
+  [[nodiscard]] constexpr uint64_t get_row(size_t r) const {
+    return rows[r];
+  }
+
+  constexpr void set_row(size_t r, uint64_t value) {
+    rows[r] = value & col_mask(num_cols);
+  }
+
+  [[nodiscard]] constexpr bool get(size_t r, size_t c) const {
+    return (rows[r] >> c) & 1ULL;
+  }
+
+  constexpr void set(size_t r, size_t c, bool value) {
+    rows[r] = (rows[r] & ~(1ULL << c)) | ((uint64_t) value << c);
+  }
+
+  /// Computes the product of this matrix and the vector v.
+  [[nodiscard]] constexpr uint64_t apply(uint64_t v) const {
+    uint64_t res = 0;
+    for (size_t r = 0; r < num_rows; ++r) res |= (uint64_t) parity(rows[r] & v) << r;
+    return res;
+  }
+
+  /// Computes the product of this matrix and other, whose number of rows must equal this matrix' number of columns.
+  [[nodiscard]] constexpr GF2Matrix multiply(const GF2Matrix &other) const {
+    GF2Matrix res(num_rows, other.num_cols);
+    for (size_t r = 0; r < num_rows; ++r) {
+      for (size_t c = 0; c < num_cols; ++c) {
+        if (get(r, c)) res.rows[r] ^= other.rows[c];
+      }
+    }
+    return res;
+  }
+
+  [[nodiscard]] constexpr GF2Matrix transpose() const {
+    GF2Matrix res(num_cols, num_rows);
+    for (size_t r = 0; r < num_rows; ++r) {
+      for (size_t c = 0; c < num_cols; ++c) {
+        if (get(r, c)) res.rows[c] |= 1ULL << r;
+      }
+    }
+    return res;
+  }
+
+  [[nodiscard]] constexpr size_t rank() const {
+    auto a = rows;
+    std::array<uint64_t, MAX_SIZE> aux{};
+    std::array<size_t, MAX_SIZE> pivots{};
+    return eliminate(a, aux, num_rows, num_cols, pivots);
+  }
+
+  /// Computes the inverse of this (square) matrix. Returns false if the matrix is singular.
+  constexpr bool inverse(GF2Matrix &inv) const {
+    if (num_rows!=num_cols) return false;
+    auto a = rows;
+    inv = identity(num_rows);
+    std::array<size_t, MAX_SIZE> pivots{};
+    // if the matrix has full rank, its reduced row echelon form is the identity, and the row operations that lead to
+    // it turn the identity into the inverse
+    return eliminate(a, inv.rows, num_rows, num_cols, pivots)==num_rows;
+  }
+
+  /// Returns a matrix whose rows are a basis of the nullspace, i.e., of all vectors v with apply(v) = 0.
+  [[nodiscard]] constexpr GF2Matrix nullspace() const {
+    auto a = rows;
+    std::array<uint64_t, MAX_SIZE> aux{};
+    std::array<size_t, MAX_SIZE> pivots{};
+    const size_t rank = eliminate(a, aux, num_rows, num_cols, pivots);
+
+    GF2Matrix basis(num_cols - rank, num_cols);
+    size_t n = 0, p = 0;
+    for (size_t c = 0; c < num_cols; ++c) {
+      if (p < rank && pivots[p]==c) {
+        ++p;
+        continue;
+      }
+      // set the free variable c and solve for the pivot variables, all other free variables are 0
+      uint64_t v = 1ULL << c;
+      for (size_t r = 0; r < rank; ++r) {
+        if (a[r] & (1ULL << c)) v |= 1ULL << pivots[r];
+      }
+      basis.rows[n++] = v;
+    }
+    return basis;
+  }
+
+  /// Finds a vector x with apply(x) = b, setting all free variables to 0. Returns false if there is no solution.
+  constexpr bool solve(uint64_t b, uint64_t &x) const {
+    auto a = rows;
+    std::array<uint64_t, MAX_SIZE> rhs{};
+    for (size_t r = 0; r < num_rows; ++r) rhs[r] = (b >> r) & 1ULL;
+    std::array<size_t, MAX_SIZE> pivots{};
+    const size_t rank = eliminate(a, rhs, num_rows, num_cols, pivots);
+
+    // the remaining rows are zero, so the system is only consistent if their right-hand sides are as well
+    for (size_t r = rank; r < num_rows; ++r) {
+      if (rhs[r]) return false;
+    }
+    x = 0;
+    for (size_t r = 0; r < rank; ++r) x |= rhs[r] << pivots[r];
+    return true;
+  }
+
+  constexpr bool operator==(const GF2Matrix &other) const {
+    if (num_rows!=other.num_rows || num_cols!=other.num_cols) return false;
+    for (size_t r = 0; r < num_rows; ++r) {
+      if (rows[r]!=other.rows[r]) return false;
+    }
+    return true;
+  }
+
+  constexpr bool operator!=(const GF2Matrix &other) const {
+    return !(*this==other);
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_UTILITIES_GF2MATRIX_HPP_
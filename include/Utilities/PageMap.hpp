@@ -0,0 +1,13 @@
+#ifndef BLACKSMITH_INCLUDE_UTILITIES_PAGEMAP_HPP_
+#define BLACKSMITH_INCLUDE_UTILITIES_PAGEMAP_HPP_
+
+#include <cstdint>
+
+class PageMap {
+ public:
+  /// Looks up the physical address backing the given virtual address in /proc/self/pagemap. Returns false if the page
+  /// is not present or the physical address is hidden, which the kernel does for processes without CAP_SYS_ADMIN.
+  static bool get_physical_address(const volatile void *address, uint64_t &physical_address);
+};
+
+#endif //BLACKSMITH_INCLUDE_UTILITIES_PAGEMAP_HPP_
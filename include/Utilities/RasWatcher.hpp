@@ -4,7 +4,9 @@
 
 #include "Fuzzer/PatternAddressMapper.hpp"
 
+#include <map>
 #include <sqlite3.h>
+#include <string>
 
 class RasWatcher {
   public:
@@ -13,17 +15,24 @@ class RasWatcher {
     ~RasWatcher();
     
     int report_corrected_bitflips(PatternAddressMapper &mapping);
+    
+    //Returns the number of ECC corrections reported since this watcher was created, per DIMM label as reported by the
+    //EDAC driver (e.g., "CPU_SrcID#0_MC#0_Chan#1_DIMM#0")
+    const std::map<std::string, int> &get_corrections_per_label() const;
   
   private:
     sqlite3 *ras_db;
     int total_corrections = 0;
+    std::map<std::string, int> total_corrections_per_label;
+    std::map<std::string, int> new_corrections_per_label;
+    std::map<std::string, int> corrections_per_label;
     
-    //Fetches the current number of rows in the table which stores ECC event records,
-    //then returns how much that number has increased by since the last call
+    //Fetches the current number of rows per DIMM label in the table which stores ECC event records,
+    //then returns how much their sum has increased by since the last call
     int fetch_new_corrections();
     
-    //Automatically called after every call to sqlite3_exec, which is why the header has to be weird
-    //Extracts the actual result from the data param, converts it from a string to an int, then puts it in the int pointed to by the value param
-    //The 4th arg of sqlite3_exec becomes the value param, so that's how we extract the number into new_total_corrections
+    //Automatically called for every result row after every call to sqlite3_exec, which is why the header has to be weird
+    //Extracts the label and the count from the data param, converts the count from a string to an int, then puts it in the map pointed to by the value param
+    //The 4th arg of sqlite3_exec becomes the value param, so that's how we extract the numbers into the map of fetch_new_corrections
     static int callback(void *value, int, char **data, char **);
 };
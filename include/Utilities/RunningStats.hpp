@@ -0,0 +1,55 @@
+#ifndef BLACKSMITH_INCLUDE_UTILITIES_RUNNINGSTATS_HPP_
+#define BLACKSMITH_INCLUDE_UTILITIES_RUNNINGSTATS_HPP_
+
+#include <cmath>
+#include <cstddef>
+
+// The mean and variance of a stream of values, updated in constant time and space per value (Welford's algorithm),
+// which unlike summing up the values and their squares does not lose precision when the variance is small compared to
+// the mean.
+class RunningStats {
+ private:
+  size_t count = 0;
+  double mean = 0;
+  // the sum of the squared differences from the mean
+  double m2 = 0;
+
+ public:
+  void add(double value) {
+    count++;
+    const double delta = value - mean;
+    mean += delta/static_cast<double>(count);
+    m2 += delta*(value - mean);
+  }
+
+  void clear() {
+    count = 0;
+    mean = 0;
+    m2 = 0;
+  }
+
+  [[nodiscard]] size_t get_count() const {
+    return count;
+  }
+
+  [[nodiscard]] double get_mean() const {
+    return mean;
+  }
+
+  /// Returns the sample variance (0 for fewer than two values).
+  [[nodiscard]] double get_variance() const {
+    return (count < 2) ? 0 : m2/static_cast<double>(count - 1);
+  }
+
+  [[nodiscard]] double get_std() const {
+    return std::sqrt(get_variance());
+  }
+
+  /// Returns the half-width of the confidence interval of the mean for the given z-value (e.g., 1.96 for 95%), using
+  /// the normal approximation, which holds for a few dozen values or more.
+  [[nodiscard]] double get_ci_half_width(double z = 1.96) const {
+    return (count < 2) ? INFINITY : z*get_std()/std::sqrt(static_cast<double>(count));
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_UTILITIES_RUNNINGSTATS_HPP_
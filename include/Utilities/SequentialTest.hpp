@@ -0,0 +1,75 @@
+#ifndef BLACKSMITH_INCLUDE_UTILITIES_SEQUENTIALTEST_HPP_
+#define BLACKSMITH_INCLUDE_UTILITIES_SEQUENTIALTEST_HPP_
+
+#include <cmath>
+#include <cstddef>
+
+// Wald's sequential probability ratio test (SPRT) of whether some event (e.g., a measurement contradicting the config)
+// occurs at a rate of at most low_rate or at least high_rate. Samples are added one at a time, and the test decides as
+// soon as the evidence suffices for the given error probabilities, which usually takes far fewer samples than a test
+// of fixed size. Rates in between the two are accepted as either one.
+class SequentialTest {
+ public:
+  enum class Decision {
+    UNDECIDED, LOW_RATE, HIGH_RATE
+  };
+
+ private:
+  // the log-likelihood ratio of the samples so far and the amounts each event/non-event adds to it
+  double llr = 0;
+  double event_llr;
+  double non_event_llr;
+
+  // the log-likelihood ratios at which the test decides for high_rate and low_rate, respectively
+  double upper_bound;
+  double lower_bound;
+
+  size_t num_samples = 0;
+  size_t num_events = 0;
+
+  Decision decision = Decision::UNDECIDED;
+
+ public:
+  /// Creates a test that wrongly decides for a high rate with probability at most false_high and wrongly decides for a
+  /// low rate with probability at most false_low. Requires 0 < low_rate < high_rate < 1.
+  SequentialTest(double low_rate, double high_rate, double false_high, double false_low)
+      : event_llr(std::log(high_rate/low_rate)),
+        non_event_llr(std::log((1 - high_rate)/(1 - low_rate))),
+        upper_bound(std::log((1 - false_low)/false_high)),
+        lower_bound(std::log(false_low/(1 - false_high))) {}
+
+  /// Adds a sample and returns the decision so far. Once the test has decided, further samples are still counted
+  /// (see get_rate) but do not change the decision.
+  Decision add(bool event) {
+    num_samples++;
+    if (event) num_events++;
+    if (decision==Decision::UNDECIDED) {
+      llr += event ? event_llr : non_event_llr;
+      if (llr >= upper_bound) {
+        decision = Decision::HIGH_RATE;
+      } else if (llr <= lower_bound) {
+        decision = Decision::LOW_RATE;
+      }
+    }
+    return decision;
+  }
+
+  [[nodiscard]] Decision get_decision() const {
+    return decision;
+  }
+
+  [[nodiscard]] size_t get_num_samples() const {
+    return num_samples;
+  }
+
+  [[nodiscard]] size_t get_num_events() const {
+    return num_events;
+  }
+
+  /// Returns the observed rate of the event, i.e., the fraction of samples that were events.
+  [[nodiscard]] double get_rate() const {
+    return (num_samples==0) ? 0 : static_cast<double>(num_events)/static_cast<double>(num_samples);
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_UTILITIES_SEQUENTIALTEST_HPP_
@@ -0,0 +1,87 @@
+#ifndef BLACKSMITH_INCLUDE_UTILITIES_THRESHOLDCALIBRATOR_HPP_
+#define BLACKSMITH_INCLUDE_UTILITIES_THRESHOLDCALIBRATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Separates a bimodal distribution of access latencies (e.g., row hits and row conflicts) into its fast and its slow
+// mode. The latencies are collected in a histogram, and the threshold between the modes is the one that maximizes
+// the variance between them (Otsu's method), which unlike the midpoint of two averages is not skewed by outliers
+// (e.g., accesses delayed by interrupts) as long as they are rare.
+class ThresholdCalibrator {
+ public:
+  // latencies at or above this are outliers, they are counted but not used to determine the threshold
+  static constexpr size_t MAX_LATENCY = 4096;
+
+ private:
+  // the number of samples that must be in each mode before they can be considered separated
+  size_t min_mode_samples;
+
+  // the minimal distance between the means of the modes (in units of their pooled standard deviation) for them to be
+  // considered separated
+  double min_separation;
+
+  // the number of samples of each latency below MAX_LATENCY
+  std::vector<size_t> histogram;
+
+  size_t num_samples = 0;
+  size_t num_outliers = 0;
+
+  // the smallest and largest latency below MAX_LATENCY seen so far
+  size_t min_latency = MAX_LATENCY;
+  size_t max_latency = 0;
+
+  // the result of the last call to update
+  size_t threshold = 0;
+  size_t previous_threshold = 0;
+  size_t fast_count = 0;
+  size_t slow_count = 0;
+  double fast_mean = 0;
+  double slow_mean = 0;
+  double separation = 0;
+
+  // computes the threshold and the statistics of the modes
+  void update();
+
+ public:
+  explicit ThresholdCalibrator(size_t min_mode_samples = 16, double min_separation = 3.0);
+
+  void add(uint64_t latency);
+
+  /// Recomputes the threshold and returns whether the modes are separated with confidence: both contain enough
+  /// samples, their means are far apart, and the threshold did not move (by more than 1%) since the previous call.
+  bool is_separated();
+
+  /// Returns the threshold computed by the last call to is_separated: latencies above it belong to the slow mode.
+  [[nodiscard]] size_t get_threshold() const {
+    return threshold;
+  }
+
+  [[nodiscard]] size_t get_num_samples() const {
+    return num_samples;
+  }
+
+  [[nodiscard]] size_t get_num_outliers() const {
+    return num_outliers;
+  }
+
+  [[nodiscard]] double get_fast_mean() const {
+    return fast_mean;
+  }
+
+  [[nodiscard]] double get_slow_mean() const {
+    return slow_mean;
+  }
+
+  [[nodiscard]] size_t get_slow_count() const {
+    return slow_count;
+  }
+
+  /// Returns the distance between the means of the modes in units of their pooled standard deviation.
+  [[nodiscard]] double get_separation() const {
+    return separation;
+  }
+};
+
+#endif //BLACKSMITH_INCLUDE_UTILITIES_THRESHOLDCALIBRATOR_HPP_
@@ -1,5 +1,6 @@
 #include "Blacksmith.hpp"
 
+#include <sys/mman.h>
 #include <sys/resource.h>
 #include <cstdio>
 #include <iostream>
@@ -7,17 +8,25 @@
 #include <stdexcept>
 #include <string>
 #include <array>
+#include <algorithm>
+#include <sstream>
 
 #include "Forges/FuzzyHammerer.hpp"
+#include "Memory/CalibrationCache.hpp"
+#include "Memory/ConfigDiscovery.hpp"
 #include "Utilities/BlacksmithConfig.hpp"
+#include "Utilities/TimeHelper.hpp"
 
 #include <argagg/argagg.hpp>
 #include <argagg/convert/csv.hpp>
 
 ProgramArguments program_args;
+int64_t program_start_ts_us;
 RasWatcher *ras_watcher;
+RegionScrubber *region_scrubber = nullptr;
 
 int main(int argc, char **argv) {
+  program_start_ts_us = get_timestamp_us();
   Logger::initialize("/dev/stdout");
 
   handle_args(argc, argv);
@@ -26,44 +35,81 @@ int main(int argc, char **argv) {
   Logger::initialize(program_args.logfile);
   Logger::stdout(true);
 
+  // give this process the highest CPU priority so it can hammer with less interruptions
+  int ret = setpriority(PRIO_PROCESS, 0, -20);
+  if (ret!=0) Logger::log_error("Instruction setpriority failed.");
+
+  if (!program_args.discover_config.empty()) {
+    run_config_discovery();
+    Logger::close();
+    return EXIT_SUCCESS;
+  }
+
   // load config
   Logger::log_debug("Loading DRAM config");
   BlacksmithConfig config = BlacksmithConfig::from_jsonfile(program_args.config);
-  DRAMAddr::set_config(config);
 
   // prints the current git commit and some program metadata
   Logger::log_metadata(GIT_COMMIT_HASH, config, program_args.runtime_limit);
 
-  // give this process the highest CPU priority so it can hammer with less interruptions
-  int ret = setpriority(PRIO_PROCESS, 0, -20);
-  if (ret!=0) Logger::log_error("Instruction setpriority failed.");
+  // allocate a large bulk of contiguous memory, at the default address if possible
+  auto pool = Memory::map_superpages((volatile char *) Memory::DEFAULT_START_ADDRESS, program_args.memory, true);
 
-  // allocate a large bulk of contiguous memory
-  Memory memory(config, true);
-  memory.allocate_memory();
+  // the address mapping of the config applied to the memory pool, wherever it was placed
+  TranslationContext ctx(config, pool, program_args.memory);
 
-  DramAnalyzer dram_analyzer(config, memory.get_starting_address());
+  Memory memory(ctx, program_args.seed, program_args.lazy_init);
+  memory.allocate_memory();
 
-  // initialize the DRAMAddr class to load the proper memory configuration
-  DRAMAddr::initialize(memory.get_starting_address());
+  DramAnalyzer dram_analyzer(ctx);
 
   // count the number of possible activations per refresh interval
-  // and check the correctness of the memory mapping function in the config
-  uint64_t acts_per_trefi = dram_analyzer.analyze_dram(true);
+  // and check the correctness of the memory mapping function in the config,
+  // unless a previous run on this system already did so
+  Logger::log_info(format_string("Using the calibration cache %s.", program_args.calibration_cache.c_str()));
+  CalibrationCache calibration_cache(program_args.calibration_cache, config);
+  uint64_t acts_per_trefi = dram_analyzer.analyze_dram(true, &calibration_cache, !program_args.recalibrate);
   
   // start the rasdaemon watcher
   ras_watcher = new RasWatcher();
-  
-  FuzzyHammerer::n_sided_frequency_based_hammering(config, dram_analyzer, memory,
+
+  // start the background scrubber only now as it would disturb the timing measurements above
+  if (program_args.scrub_rate > 0) {
+    region_scrubber = new RegionScrubber(memory, program_args.scrub_rate);
+    region_scrubber->start();
+  }
+
+  FuzzyHammerer::n_sided_frequency_based_hammering(ctx, dram_analyzer, memory,
                                                    acts_per_trefi,
                                                    program_args.runtime_limit,
                                                    program_args.num_address_mappings_per_pattern);
 
+  // the scrubber accesses the memory, so it must be stopped before the memory is unmapped
+  delete region_scrubber;
   Logger::close();
   delete ras_watcher;
   return EXIT_SUCCESS;
 }
 
+void run_config_discovery() {
+  // the mapping is determined within one superpage, whose offsets are also the lower bits of its physical addresses
+  auto superpage = Memory::map_superpages((volatile char *) Memory::DEFAULT_START_ADDRESS, 1, true);
+
+  // name the config after its file, like the configs in config/
+  std::string name = program_args.discover_config.substr(program_args.discover_config.find_last_of('/') + 1);
+  if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json")==0) name.resize(name.size() - 5);
+
+  DramTimingSource timing(ConfigDiscovery::MEASURE_ROUNDS);
+  ConfigDiscovery discovery(superpage, timing, std::random_device()());
+  const BlacksmithConfig config = discovery.discover(name);
+  config.to_jsonfile(program_args.discover_config);
+  Logger::log_info(format_string("Wrote the discovered config to %s. Its channels, dimms, and ranks are placeholders "
+                                 "that timing cannot determine, please fill them in.",
+      program_args.discover_config.c_str()));
+
+  munmap((void *) superpage, HUGEPAGE_SIZE);
+}
+
 void handle_args(int argc, char **argv) {
   // An option is specified by four things:
   //    (1) the name of the option,
@@ -74,12 +120,20 @@ void handle_args(int argc, char **argv) {
       {"help", {"-h", "--help"}, "shows this help message", 0},
 
       {"config", {"-c", "--config"}, "loads the specified config file (JSON) as DRAM address config", 1},
+      {"discover-config", {"--discover-config"}, "determines the DRAM address mapping by timing row conflicts and writes it as config file (JSON) to the given path instead of fuzzing", 1},
 
       {"runtime-limit", {"-t", "--runtime-limit"}, "number of hours to run the fuzzer before terminating (default: 3)", 1},
       {"logfile", {"-l", "--logfile"}, "log to specified file (default: run.log)", 1},
       
       {"probes", {"-p", "--probes"}, "number of different DRAM locations to try each pattern on (default: 3)", 1},
-      {"effective-patterns", {"-e", "--effective-patterns"}, "number of effective hammering patterns to be found for a run to end before its runtime limit (default: 3)", 1}
+      {"effective-patterns", {"-e", "--effective-patterns"}, "number of effective hammering patterns to be found for a run to end before its runtime limit (default: 3)", 1},
+      {"memory", {"-m", "--memory"}, "number of 1 GB hugepages to allocate and test (default: 1)", 1},
+      {"seed", {"--seed"}, "seed for the data written to memory, to reproduce a previous run (default: random)", 1},
+      {"lazy-init", {"--lazy-init"}, "initialize rows only when a pattern uses them for the first time, for a faster startup", 0},
+      {"data-patterns", {"--data-patterns"}, "comma-separated list of data patterns the probes rotate through: random, zeroes, ones, row_stripe, checkerboard, column_stripe, aggressor_inverse (default: random)", 1},
+      {"scrub-rate", {"--scrub-rate"}, "scan the memory for bit flips outside the victim rows in the background at this rate in MiB/s (default: 0 = off)", 1},
+      {"calibration-cache", {"--calibration-cache"}, "file to cache the timing calibration in, so later runs on the same system can skip it (default: calibration_cache.json next to the logfile)", 1},
+      {"recalibrate", {"--recalibrate"}, "calibrate the timing even if the calibration cache holds a calibration for this system", 0}
     }};
 
   argagg::parser_results parsed_args;
@@ -98,11 +152,16 @@ void handle_args(int argc, char **argv) {
   /**
    * mandatory parameters
    */
-  if (parsed_args.has_option("config")) {
+  if (parsed_args.has_option("discover-config")) {
+      // the config is discovered instead of loaded
+      program_args.discover_config = parsed_args["discover-config"].as<std::string>("");
+      Logger::log_debug(format_string("Set --discover-config = %s", program_args.discover_config.c_str()));
+  } else if (parsed_args.has_option("config")) {
       program_args.config = parsed_args["config"].as<std::string>("");
       Logger::log_debug(format_string("Set --config = %s", program_args.config.c_str()));
   } else {
-      Logger::log_error("Program argument '--config <string>' is mandatory! Cannot continue.");
+      Logger::log_error("Program argument '--config <string>' is mandatory (unless '--discover-config <string>' is "
+                        "given)! Cannot continue.");
       exit(EXIT_FAILURE);
   }
 
@@ -120,4 +179,56 @@ void handle_args(int argc, char **argv) {
   
   program_args.effective_patterns = parsed_args["effective-patterns"].as<size_t>(program_args.effective_patterns);
   Logger::log_debug(format_string("Set --effective-patterns = %d", program_args.effective_patterns));
+
+  program_args.memory = parsed_args["memory"].as<size_t>(program_args.memory);
+  if (program_args.memory == 0) {
+    Logger::log_error("Program argument '--memory <number>' must be at least 1.");
+    exit(EXIT_FAILURE);
+  }
+  Logger::log_debug(format_string("Set --memory = %zu", program_args.memory));
+
+  if (parsed_args.has_option("seed")) {
+    program_args.seed = parsed_args["seed"].as<uint64_t>();
+    Logger::log_debug(format_string("Set --seed = %lu", program_args.seed.value()));
+  }
+
+  program_args.lazy_init = parsed_args.has_option("lazy-init");
+  Logger::log_debug(format_string("Set --lazy-init = %s", program_args.lazy_init ? "true" : "false"));
+
+  if (parsed_args.has_option("data-patterns")) {
+    program_args.data_patterns.clear();
+    std::stringstream ss(parsed_args["data-patterns"].as<std::string>());
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+      std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+      DATA_PATTERN pattern;
+      try {
+        from_string(name, pattern);
+      } catch (const std::out_of_range &) {
+        Logger::log_error(format_string("Unknown data pattern '%s' given in '--data-patterns'.", name.c_str()));
+        exit(EXIT_FAILURE);
+      }
+      program_args.data_patterns.push_back(pattern);
+    }
+    if (program_args.data_patterns.empty()) {
+      Logger::log_error("Program argument '--data-patterns <list>' requires at least one data pattern.");
+      exit(EXIT_FAILURE);
+    }
+    Logger::log_debug(format_string("Set --data-patterns = %s", parsed_args["data-patterns"].as<std::string>().c_str()));
+  }
+
+  program_args.scrub_rate = parsed_args["scrub-rate"].as<size_t>(program_args.scrub_rate);
+  Logger::log_debug(format_string("Set --scrub-rate = %zu", program_args.scrub_rate));
+
+  program_args.calibration_cache = parsed_args["calibration-cache"].as<std::string>(program_args.calibration_cache);
+  if (program_args.calibration_cache.empty()) {
+    // keep the cache with the other output of the run rather than in whatever directory it was started from
+    const auto dir_end = program_args.logfile.find_last_of('/');
+    program_args.calibration_cache = (dir_end==std::string::npos ? "" : program_args.logfile.substr(0, dir_end + 1))
+        + "calibration_cache.json";
+  }
+  Logger::log_debug(format_string("Set --calibration-cache = %s", program_args.calibration_cache.c_str()));
+
+  program_args.recalibrate = parsed_args.has_option("recalibrate");
+  Logger::log_debug(format_string("Set --recalibrate = %s", program_args.recalibrate ? "true" : "false"));
 }
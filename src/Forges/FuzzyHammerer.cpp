@@ -2,6 +2,8 @@
 
 #include <Blacksmith.hpp>
 
+#include <map>
+
 #include "Utilities/TimeHelper.hpp"
 #include "Fuzzer/PatternBuilder.hpp"
 
@@ -10,11 +12,16 @@ size_t FuzzyHammerer::cnt_pattern_probes = 0UL;
 size_t FuzzyHammerer::cnt_generated_patterns = 0UL;
 std::unordered_map<std::string, std::unordered_map<std::string, int>> FuzzyHammerer::map_pattern_mappings_bitflips;
 HammeringPattern FuzzyHammerer::hammering_pattern = HammeringPattern(); /* NOLINT */
-size_t total_corrected = 0, total_uncorrected = 0;
+SyncDriftDetector FuzzyHammerer::sync_drift_detector;
+bool FuzzyHammerer::hammered_before = false;
+size_t total_corrected = 0, total_uncorrected = 0, total_out_of_window = 0;
+// the uncorrected bit flips per DIMM, only collected if the config labels the channel and DIMM bank functions
+std::map<std::string, size_t> uncorrected_per_dimm;
 
 void
-FuzzyHammerer::n_sided_frequency_based_hammering(BlacksmithConfig &config, DramAnalyzer &dramAnalyzer, Memory &memory,
-                                                 uint64_t acts, size_t runtime_limit, size_t probes_per_pattern) {
+FuzzyHammerer::n_sided_frequency_based_hammering(const TranslationContext &ctx, DramAnalyzer &dramAnalyzer,
+                                                 Memory &memory, uint64_t acts, size_t runtime_limit,
+                                                 size_t probes_per_pattern) {
   std::mt19937 gen = std::mt19937(std::random_device()());
 
   Logger::log_progress(format_string("Fuzzing has started. Details are being written to %s. Any detected bitflips will also be written to the console.", program_args.logfile.c_str()));
@@ -23,15 +30,18 @@ FuzzyHammerer::n_sided_frequency_based_hammering(BlacksmithConfig &config, DramA
 
   // make sure that this is empty (e.g., from previous call to this function)
   map_pattern_mappings_bitflips.clear();
+  sync_drift_detector.reset();
 
-  FuzzingParameterSet fuzzing_params(acts);
+  FuzzingParameterSet fuzzing_params(acts, ctx.get_row_count());
+  fuzzing_params.set_refresh_profile(dramAnalyzer.get_refresh_profile());
+  fuzzing_params.set_data_patterns(program_args.data_patterns);
   fuzzing_params.print_static_parameters();
 
   // all patterns that triggered bit flips
   std::vector<HammeringPattern> effective_patterns;
 
   HammeringPattern best_hammering_pattern;
-  PatternAddressMapper best_mapping(config.total_banks);
+  PatternAddressMapper best_mapping(ctx);
 
   size_t best_mapping_bitflips = 0;
   size_t best_hammering_pattern_bitflips = 0;
@@ -61,7 +71,7 @@ FuzzyHammerer::n_sided_frequency_based_hammering(BlacksmithConfig &config, DramA
     // then test this pattern with N different mappings (i.e., address sets)
     size_t sum_flips_one_pattern_all_mappings = 0;
     for (cnt_pattern_probes = 0; cnt_pattern_probes < probes_per_pattern; ++cnt_pattern_probes) {
-      PatternAddressMapper mapper(config.total_banks);
+      PatternAddressMapper mapper(ctx);
 
       // we test this combination of (pattern, mapping) at three different DRAM locations
       probe_mapping_and_scan(mapper, memory, fuzzing_params, program_args.num_dram_locations_per_mapping);
@@ -99,16 +109,23 @@ FuzzyHammerer::n_sided_frequency_based_hammering(BlacksmithConfig &config, DramA
     if (effective_patterns.size() >= program_args.effective_patterns)
       break;
 
-    // dynamically change num acts per tREF after every 100 patterns; this is to avoid that we made a bad choice at the
-    // beginning and then get stuck with that value
-    if (cnt_generated_patterns % 100 == 0) {
+    // measure the num acts per tREF again once the hammering no longer synchronizes with the refreshes as it did right
+    // after the last measurement; this is to avoid that we made a bad choice at the beginning (or the timing changed
+    // since) and then get stuck with that value
+    if (sync_drift_detector.has_drifted()) {
+      Logger::log_info(format_string("Synchronization with the refreshes drifted: %.1f rounds per sync over the last "
+                                     "%zu hammering runs, %.1f before.", sync_drift_detector.get_window_mean(),
+          sync_drift_detector.get_window_size(), sync_drift_detector.get_baseline_mean()));
       auto old_nacts = fuzzing_params.get_num_activations_per_t_refi();
-      // repeat measuring the number of possible activations per tREF as it might be that the current value is not optimal
-      fuzzing_params.set_num_activations_per_t_refi(static_cast<int>(dramAnalyzer.analyze_dram(false)));
+      if (region_scrubber!=nullptr) region_scrubber->pause();
+      fuzzing_params.set_num_activations_per_t_refi(static_cast<int>(dramAnalyzer.measure_acts_per_trefi()));
+      fuzzing_params.set_refresh_profile(dramAnalyzer.get_refresh_profile());
+      if (region_scrubber!=nullptr) region_scrubber->resume();
       Logger::log_info(
           format_string("Recomputed number of row activations per refresh interval (old: %d, new: %d).",
                         old_nacts,
                         fuzzing_params.get_num_activations_per_t_refi()));
+      sync_drift_detector.reset();
     }
 
   } // end of fuzzing
@@ -118,6 +135,18 @@ FuzzyHammerer::n_sided_frequency_based_hammering(BlacksmithConfig &config, DramA
   Logger::log_info(format_string("Fuzzing run finished after %s.", Logger::timestamp().c_str()));
   Logger::log_info(format_string("Total corrected bit flips: %zu", total_corrected));
   Logger::log_info(format_string("Total uncorrected bit flips: %zu", total_uncorrected));
+  for (const auto &entry : ras_watcher->get_corrections_per_label()) {
+    Logger::log_info(format_string("Corrected bit flips on %s: %d", entry.first.c_str(), entry.second));
+  }
+  for (const auto &entry : uncorrected_per_dimm) {
+    Logger::log_info(format_string("Uncorrected bit flips on %s: %zu", entry.first.c_str(), entry.second));
+  }
+  if (region_scrubber!=nullptr) {
+    region_scrubber->stop();
+    total_out_of_window += region_scrubber->report_bitflips();
+    Logger::log_info(format_string("Total bit flips outside of victim windows (found by scrubber): %zu",
+        total_out_of_window));
+  }
   if (total_corrected > 0) {
     if (total_uncorrected == 0)
       Logger::log_success("ECC is most likely functioning correctly on this system.");
@@ -142,6 +171,9 @@ void FuzzyHammerer::probe_mapping_and_scan(PatternAddressMapper &mapper, Memory
 
   // randomize the aggressor ID -> DRAM row mapping
   mapper.randomize_addresses(fuzzing_params, hammering_pattern.agg_access_patterns, true);
+  mapper.data_pattern = fuzzing_params.get_next_data_pattern();
+  mapper.data_seed = memory.get_seed();
+  Logger::log_info(format_string("Using data pattern %s.", to_string(mapper.data_pattern).c_str()));
 
   // now fill the pattern with these random addresses
   std::vector<volatile char *> hammering_accesses_vec;
@@ -175,18 +207,49 @@ void FuzzyHammerer::probe_mapping_and_scan(PatternAddressMapper &mapper, Memory
     auto wait_until_hammering_us = fuzzing_params.get_random_wait_until_start_hammering_us();
     FuzzingParameterSet::print_dynamic_parameters2(sync_at_each_ref, wait_until_hammering_us, num_aggs_for_sync);
 
+    // the scrubber must neither disturb the hammering nor see the bit flips before check_memory does
+    if (region_scrubber!=nullptr) {
+      region_scrubber->pause();
+      total_out_of_window += region_scrubber->report_bitflips();
+      region_scrubber->set_mapping(mapper.get_instance_id());
+    }
+
+    // restore and initialize the rows (while the scrubber is paused, as it would see half-written rows) before the
+    // random accesses, so that the randomized wait is the last thing before hammering
+    memory.prepare_probe(mapper);
+
+    // the addresses are computed before the timed accesses, which should only touch memory
     std::vector<volatile char *> random_rows;
     if (wait_until_hammering_us > 0) {
-      random_rows = mapper.get_random_nonaccessed_rows(fuzzing_params.get_max_row_no());
+      const auto rows = mapper.get_random_nonaccessed_rows(fuzzing_params.get_max_row_no());
+      random_rows.assign(rows.begin(), rows.end());
       do_random_accesses(random_rows, wait_until_hammering_us);
     }
 
+    // report the startup time once, i.e., the time from launching the program until the first hammering
+    if (!hammered_before) {
+      hammered_before = true;
+      Logger::log_info(format_string("Time from launch to first hammering: %ld ms.",
+          (get_timestamp_us() - program_start_ts_us)/1000));
+    }
+
     // do hammering
-    code_jitter.hammer_pattern(fuzzing_params, true);
+    const int total_sync_acts = code_jitter.hammer_pattern(fuzzing_params, true);
+    if (total_sync_acts >= 0) {
+      // the synchronizations time rounds of num_aggs_for_sync accesses each
+      sync_drift_detector.add(static_cast<double>(total_sync_acts)
+                                  /(code_jitter.get_num_synced_refs(fuzzing_params)*code_jitter.num_aggs_for_sync));
+    }
 
     // check if any uncorrected bit flips happened
     uncorrected += memory.check_memory(mapper, false, true);
-    
+    if (memory.get_context().has_bank_labels()) {
+      for (const auto &flip : mapper.bit_flips.back()) {
+        uncorrected_per_dimm[flip.address.get_dimm_name()] += flip.count_bit_corruptions();
+      }
+    }
+    if (region_scrubber!=nullptr) region_scrubber->resume();
+
     // check if any corrected bit flips happened
     corrected += ras_watcher->report_corrected_bitflips(mapper);
 
@@ -196,7 +259,10 @@ void FuzzyHammerer::probe_mapping_and_scan(PatternAddressMapper &mapper, Memory
 
     if (dram_location + 1 < num_dram_locations) {
       // wait a bit and do some random accesses before checking reproducibility of the pattern
-      if (random_rows.empty()) random_rows = mapper.get_random_nonaccessed_rows(fuzzing_params.get_max_row_no());
+      if (random_rows.empty()) {
+        const auto rows = mapper.get_random_nonaccessed_rows(fuzzing_params.get_max_row_no());
+        random_rows.assign(rows.begin(), rows.end());
+      }
       do_random_accesses(random_rows, 64000); // 64ms (retention time)
     }
   }
@@ -211,12 +277,12 @@ void FuzzyHammerer::probe_mapping_and_scan(PatternAddressMapper &mapper, Memory
   code_jitter.cleanup();
 }
 
-void FuzzyHammerer::generate_pattern_for_ARM(BlacksmithConfig &config,
+void FuzzyHammerer::generate_pattern_for_ARM(const TranslationContext &ctx,
                                              size_t acts,
                                              int *rows_to_access,
                                              int max_accesses,
                                              const size_t probes_per_pattern) {
-  FuzzingParameterSet fuzzing_params(acts);
+  FuzzingParameterSet fuzzing_params(acts, ctx.get_row_count());
   fuzzing_params.print_static_parameters();
   fuzzing_params.randomize_parameters(true);
 
@@ -235,7 +301,7 @@ void FuzzyHammerer::generate_pattern_for_ARM(BlacksmithConfig &config,
   Logger::log_data(hammering_pattern.get_agg_access_pairs_text_repr());
 
   // choose random addresses for pattern
-  PatternAddressMapper mapper(config.total_banks);
+  PatternAddressMapper mapper(ctx);
   mapper.randomize_addresses(fuzzing_params, hammering_pattern.agg_access_patterns, true);
   mapper.export_pattern(hammering_pattern.aggressors, hammering_pattern.base_period, rows_to_access, max_accesses);
   Logger::log_info("Aggressor ID to DRAM address mapping (bank, rank, column):");
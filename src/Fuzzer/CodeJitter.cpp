@@ -1,5 +1,7 @@
 #include "Fuzzer/CodeJitter.hpp"
 
+#include <algorithm>
+
 CodeJitter::CodeJitter()
     : pattern_sync_each_ref(false),
       flushing_strategy(FLUSHING_STRATEGY::EARLIEST_POSSIBLE),
@@ -40,16 +42,9 @@ int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool ver
     Logger::log_info("Synchronization stats:");
     Logger::log_data(format_string("Total sync acts: %d", total_sync_acts));
 
-    const auto total_acts_pattern = fuzzing_parameters.get_total_acts_pattern();
-    auto pattern_rounds = fuzzing_parameters.get_hammering_total_num_activations()/total_acts_pattern;
-    auto acts_per_pattern_round = pattern_sync_each_ref
-                                  // sync after each num_acts_per_tREFI: computes how many activations are necessary
-                                  // by taking our pattern's length into account
-                                  ? (total_acts_pattern/fuzzing_parameters.get_num_activations_per_t_refi())
-                                  // beginning and end of pattern; for simplicity we only consider the end of the
-                                  // pattern here (=1) as this is the sync that is repeated after each hammering run
-                                  : 1;
-    auto num_synced_refs = pattern_rounds*acts_per_pattern_round;
+    auto pattern_rounds = fuzzing_parameters.get_hammering_total_num_activations()
+        /fuzzing_parameters.get_total_acts_pattern();
+    auto num_synced_refs = get_num_synced_refs(fuzzing_parameters);
     Logger::log_data(format_string("Number of pattern reps while hammering: %d", pattern_rounds));
     Logger::log_data(format_string("Number of total synced REFs (est.): %d", num_synced_refs));
     Logger::log_data(format_string("Avg. number of acts per sync: %d", total_sync_acts/num_synced_refs));
@@ -58,6 +53,20 @@ int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool ver
   return total_sync_acts;
 }
 
+int CodeJitter::get_num_synced_refs(const FuzzingParameterSet &fuzzing_parameters) const {
+  const auto total_acts_pattern = fuzzing_parameters.get_total_acts_pattern();
+  auto pattern_rounds = fuzzing_parameters.get_hammering_total_num_activations()/total_acts_pattern;
+  auto acts_per_pattern_round = pattern_sync_each_ref
+                                // sync after each num_acts_per_tREFI: computes how many activations are necessary
+                                // by taking our pattern's length into account
+                                ? (total_acts_pattern/fuzzing_parameters.get_num_activations_per_t_refi())
+                                // beginning and end of pattern; for simplicity we only consider the end of the
+                                // pattern here (=1) as this is the sync that is repeated after each hammering run
+                                : 1;
+  // a pattern shorter than a refresh interval may not sync after each REF, but still syncs at its end
+  return std::max(pattern_rounds*acts_per_pattern_round, 1);
+}
+
 void CodeJitter::jit_strict(int num_acts_per_trefi,
                             FLUSHING_STRATEGY flushing,
                             FENCING_STRATEGY fencing,
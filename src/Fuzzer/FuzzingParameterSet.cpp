@@ -7,9 +7,9 @@
 #endif
 
 #include "GlobalDefines.hpp"
-#include "Memory/DRAMAddr.hpp"
 
-FuzzingParameterSet::FuzzingParameterSet(int measured_num_acts_per_ref) : /* NOLINT */
+FuzzingParameterSet::FuzzingParameterSet(int measured_num_acts_per_ref, size_t num_rows) : /* NOLINT */
+    max_row_no(static_cast<int>(num_rows)),
     flushing_strategy(FLUSHING_STRATEGY::EARLIEST_POSSIBLE),
     fencing_strategy(FENCING_STRATEGY::LATEST_POSSIBLE) {
   std::random_device rd;
@@ -26,7 +26,12 @@ void FuzzingParameterSet::print_static_parameters() const {
   Logger::log_data(format_string("agg_intra_distance: %d", agg_intra_distance));
   Logger::log_data(format_string("N_sided dist.: %s", get_dist_string().c_str()));
   Logger::log_data(format_string("hammering_total_num_activations: %d", hammering_total_num_activations));
+  Logger::log_data(format_string("trefi_us: %.3f%s", get_trefi_us(),
+      refresh_profile.is_valid() ? (refresh_profile.double_refresh ? " (2x refresh)" : "") : " (assumed)"));
   Logger::log_data(format_string("max_row_no: %d", max_row_no));
+  std::string patterns;
+  for (const auto &p : data_patterns) patterns += (patterns.empty() ? "" : ", ") + to_string(p);
+  Logger::log_data(format_string("data_patterns: %s", patterns.c_str()));
 }
 
 void FuzzingParameterSet::print_semi_dynamic_parameters() const {
@@ -40,8 +45,9 @@ void FuzzingParameterSet::print_semi_dynamic_parameters() const {
   Logger::log_data(format_string("fencing_strategy: %s", to_string(fencing_strategy).c_str()));
 }
 
-void FuzzingParameterSet::print_dynamic_parameters(const int bank, bool seq_addresses, int start_row) {
+void FuzzingParameterSet::print_dynamic_parameters(size_t page, const int bank, bool seq_addresses, int start_row) {
   Logger::log_info("Printing DRAM address-related fuzzing parameters:");
+  Logger::log_data(format_string("page_no: %zu", page));
   Logger::log_data(format_string("bank_no: %d", bank));
   Logger::log_data(format_string("use_seq_addresses: %s", (seq_addresses ? "true" : "false")));
   Logger::log_data(format_string("start_row: %d", start_row));
@@ -155,10 +161,10 @@ void FuzzingParameterSet::randomize_parameters(bool print) {
   // [CANNOT be derived from anywhere else - must explicitly be exported]
   // hammering_total_num_activations is derived as follow:
   //    REF interval: 7.8 μs (tREFI), retention time: 64 ms   => about 8k REFs per refresh window
-  //    num_activations_per_tREFI ≈100                       => 8k * 100 ≈ 8M activations and we hammer for 5M acts.
-  hammering_total_num_activations = 5000000;
-
-  max_row_no = DRAMAddr::get_row_count();
+  //    num_activations_per_tREFI ≈100                       => 8k * 100 ≈ 800k activations per refresh window and we
+  //                                                             hammer for 5M acts, i.e., about 390 ms
+  // if the refresh interval was profiled, we hammer for as many REFs as the profiled tREFI fits into these 390 ms
+  update_hammering_total_num_activations();
 
   // █████████ SEMI-DYNAMIC FUZZING PARAMETERS ████████████████████████████████████████████████████
   // are only randomized once when calling this function
@@ -247,8 +253,47 @@ int FuzzingParameterSet::get_random_amplitude(int max) {
 }
 
 int FuzzingParameterSet::get_random_wait_until_start_hammering_us() {
-  // each REF interval has a length of 7.8 us
-  return static_cast<int>(static_cast<double>(wait_until_start_hammering_refs.get_random_number(gen)) * 7.8);
+  // each REF interval has a length of tREFI
+  return static_cast<int>(static_cast<double>(wait_until_start_hammering_refs.get_random_number(gen))*get_trefi_us());
+}
+
+double FuzzingParameterSet::get_trefi_us() const {
+  return refresh_profile.is_valid() ? refresh_profile.trefi_ns/1000 : RefreshProfiler::NOMINAL_TREFI_NS/1000;
+}
+
+void FuzzingParameterSet::update_hammering_total_num_activations() {
+  if (!refresh_profile.is_valid()) {
+    hammering_total_num_activations = 5000000;
+    return;
+  }
+  const auto num_refs = static_cast<int>(HAMMERING_DURATION_US/get_trefi_us());
+  hammering_total_num_activations = num_refs*num_activations_per_tREFI;
+}
+
+void FuzzingParameterSet::set_refresh_profile(const RefreshProfile &profile) {
+  // a failed measurement (e.g., a remeasurement disturbed by other processes) says nothing about the refresh cadence,
+  // so keep sizing the hammering by the last valid one
+  if (!profile.is_valid()) {
+    if (refresh_profile.is_valid()) {
+      Logger::log_info(format_string("Keeping the previous refresh interval of %.1f us as it could not be measured "
+                                     "again.", refresh_profile.trefi_ns/1000));
+    }
+    return;
+  }
+  refresh_profile = profile;
+  update_hammering_total_num_activations();
+}
+
+DATA_PATTERN FuzzingParameterSet::get_next_data_pattern() {
+  auto pattern = data_patterns.at(next_data_pattern);
+  next_data_pattern = (next_data_pattern + 1)%data_patterns.size();
+  return pattern;
+}
+
+void FuzzingParameterSet::set_data_patterns(const std::vector<DATA_PATTERN> &patterns) {
+  if (patterns.empty()) return;
+  data_patterns = patterns;
+  next_data_pattern = 0;
 }
 
 bool FuzzingParameterSet::get_random_sync_each_ref() {
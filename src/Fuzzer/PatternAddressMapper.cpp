@@ -1,17 +1,19 @@
 #include "Fuzzer/PatternAddressMapper.hpp"
 
 #include <algorithm>
+#include <tuple>
 
 #include "GlobalDefines.hpp"
 #include "Utilities/Uuid.hpp"
 
-// initialize the bank_counter (static var)
+// initialize the bank_counter and page_counter (static vars)
 int PatternAddressMapper::bank_counter = 0;
+size_t PatternAddressMapper::page_counter = 0;
 
 PatternAddressMapper::PatternAddressMapper() {}
 
-PatternAddressMapper::PatternAddressMapper(uint64_t total_banks)
-    : instance_id(uuid::gen_uuid()), total_banks(total_banks) { /* NOLINT */
+PatternAddressMapper::PatternAddressMapper(const TranslationContext &ctx)
+    : instance_id(uuid::gen_uuid()), ctx(&ctx), total_banks(ctx.get_config().total_banks) { /* NOLINT */
   code_jitter = std::make_unique<CodeJitter>();
 
   // standard mersenne_twister_engine seeded with rd()
@@ -27,11 +29,18 @@ void PatternAddressMapper::randomize_addresses(FuzzingParameterSet &fuzzing_para
 
   // retrieve and then store randomized values as they should be the same for all added addresses
   // (store bank_no as field for get_random_nonaccessed_rows)
-  bank_no = PatternAddressMapper::bank_counter;
-  PatternAddressMapper::bank_counter = (PatternAddressMapper::bank_counter + 1) % total_banks;
+  // consecutive mappings go to different channels, DIMMs, and ranks first (if the config labels them), so that every
+  // rank is covered even if only a few mappings are tested; those selected by the superpage's origin rather than by
+  // the offset within it are covered by rotating over the superpages
+  bank_no = static_cast<int>(ctx->spread_bank(static_cast<size_t>(PatternAddressMapper::bank_counter)));
+  page_no = ctx->spread_page(PatternAddressMapper::page_counter);
+  PatternAddressMapper::bank_counter =
+      (PatternAddressMapper::bank_counter + 1)%static_cast<int>(ctx->get_bank_count());
+  if (PatternAddressMapper::bank_counter == 0)
+    PatternAddressMapper::page_counter = (PatternAddressMapper::page_counter + 1) % ctx->get_page_count();
   const bool use_seq_addresses = fuzzing_params.get_random_use_seq_addresses();
   const int start_row = fuzzing_params.get_random_start_row();
-  if (verbose) FuzzingParameterSet::print_dynamic_parameters(bank_no, use_seq_addresses, start_row);
+  if (verbose) FuzzingParameterSet::print_dynamic_parameters(page_no, bank_no, use_seq_addresses, start_row);
 
   auto cur_row = static_cast<size_t>(start_row);
 
@@ -128,7 +137,8 @@ void PatternAddressMapper::randomize_addresses(FuzzingParameterSet &fuzzing_para
 
       assignment_trial_cnt = 0;
       occupied_rows.insert(row);
-      aggressor_to_addr.insert(std::make_pair(current_agg.id, DRAMAddr(static_cast<size_t>(bank_no), row, 0)));
+      aggressor_to_addr.insert(std::make_pair(current_agg.id,
+          DRAMAddr(*ctx, static_cast<size_t>(bank_no), row, 0, page_no)));
     }
   }
 
@@ -145,8 +155,7 @@ void PatternAddressMapper::randomize_addresses(FuzzingParameterSet &fuzzing_para
 
 void PatternAddressMapper::determine_victims(const std::vector<AggressorAccessPattern> &agg_access_patterns) {
   // check ROW_THRESHOLD rows around the aggressors for flipped bits
-  const int ROW_THRESHOLD = 5;
-  // a set to make sure we add victims only once
+  const size_t ROW_THRESHOLD = 5;
   victim_rows.clear();
   for (auto &acc_pattern : agg_access_patterns) {
     for (auto &agg : acc_pattern.aggressors) {
@@ -156,24 +165,20 @@ void PatternAddressMapper::determine_victims(const std::vector<AggressorAccessPa
         exit(EXIT_FAILURE);
       }
 
-      const auto dram_addr = aggressor_to_addr.at(agg.id);
-
-      for (int delta_nrows = -ROW_THRESHOLD; delta_nrows <= ROW_THRESHOLD; ++delta_nrows) {
-        auto cur_row_candidate = static_cast<int>(dram_addr.row) + delta_nrows;
-
-        // don't add the aggressor itself and ignore any non-existing (negative) row no.
-        if (delta_nrows == 0 || cur_row_candidate < 0)
-          continue;
-
-        // ignore this victim if we already added it before
-        auto victim_start = DRAMAddr(dram_addr.bank, static_cast<size_t>(cur_row_candidate), 0);
-        if (victim_rows.count(static_cast<volatile char *>(victim_start.to_virt())) > 0)
-          continue;
-
-        victim_rows.insert(static_cast<volatile char *>(victim_start.to_virt()));
+      // the neighborhood excludes the aggressor itself and any non-existing rows
+      const RowNeighborhood neighborhood(aggressor_to_addr.at(agg.id), ROW_THRESHOLD);
+      for (auto it = neighborhood.begin(); it!=neighborhood.end(); ++it) {
+        victim_rows.push_back(it.get_dram_addr());
       }
     }
   }
+
+  // make sure we add victims only once, even if the neighborhoods of several aggressors overlap
+  auto key = [](const DRAMAddr &a) { return std::make_tuple(a.page, a.bank, a.row); };
+  std::sort(victim_rows.begin(), victim_rows.end(),
+      [&key](const DRAMAddr &a, const DRAMAddr &b) { return key(a) < key(b); });
+  victim_rows.erase(std::unique(victim_rows.begin(), victim_rows.end(),
+      [&key](const DRAMAddr &a, const DRAMAddr &b) { return key(a)==key(b); }), victim_rows.end());
 }
 
 void PatternAddressMapper::export_pattern_internal(
@@ -181,6 +186,20 @@ void PatternAddressMapper::export_pattern_internal(
     std::vector<volatile char *> &addresses,
     std::vector<int> &rows) {
 
+  // translate each aggressor only once, the pattern typically accesses each of them many times
+  std::vector<AGGRESSOR_ID_TYPE> agg_ids;
+  std::vector<DRAMAddr> agg_addrs;
+  for (const auto &agg_addr : aggressor_to_addr) {
+    agg_ids.push_back(agg_addr.first);
+    agg_addrs.push_back(agg_addr.second);
+  }
+  std::vector<volatile char *> agg_virt_addrs(agg_addrs.size());
+  DRAMAddr::to_virt_batch(*ctx, agg_addrs.data(), agg_addrs.size(), agg_virt_addrs.data());
+  std::unordered_map<AGGRESSOR_ID_TYPE, volatile char *> agg_to_virt;
+  for (size_t i = 0; i < agg_ids.size(); ++i) {
+    agg_to_virt[agg_ids[i]] = agg_virt_addrs[i];
+  }
+
   bool invalid_aggs = false;
   std::stringstream pattern_str;
   for (size_t i = 0; i < aggressors.size(); ++i) {
@@ -204,7 +223,7 @@ void PatternAddressMapper::export_pattern_internal(
     }
 
     // retrieve virtual address of current aggressor in pattern and add it to output vector
-    addresses.push_back((volatile char *) aggressor_to_addr.at(agg.id).to_virt());
+    addresses.push_back(agg_to_virt.at(agg.id));
     rows.push_back(static_cast<int>(aggressor_to_addr.at(agg.id).row));
     pattern_str << aggressor_to_addr.at(agg.id).row << " ";
   }
@@ -278,7 +297,10 @@ void to_json(nlohmann::json &j, const PatternAddressMapper &p) {
                      {"min_row", p.min_row},
                      {"max_row", p.max_row},
                      {"bank_no", p.bank_no},
+                     {"page_no", p.page_no},
                      {"reproducibility_score", p.reproducibility_score},
+                     {"data_pattern", to_string(p.data_pattern)},
+                     {"data_seed", p.data_seed},
                      {"total_banks", p.total_banks},
                      {"code_jitter", *p.code_jitter}
   };
@@ -292,7 +314,23 @@ void from_json(const nlohmann::json &j, PatternAddressMapper &p) {
   j.at("min_row").get_to(p.min_row);
   j.at("max_row").get_to(p.max_row);
   j.at("bank_no").get_to(p.bank_no);
+  // to preserve backward-compatibility
+  if (j.contains("page_no")) {
+    j.at("page_no").get_to(p.page_no);
+  } else {
+    p.page_no = 0;
+  }
   j.at("reproducibility_score").get_to(p.reproducibility_score);
+  if (j.contains("data_pattern")) {
+    from_string(j.at("data_pattern"), p.data_pattern);
+  } else {
+    p.data_pattern = DATA_PATTERN::RANDOM;
+  }
+  if (j.contains("data_seed")) {
+    j.at("data_seed").get_to(p.data_seed);
+  } else {
+    p.data_seed = 0;
+  }
   j.at("total_banks").get_to(p.total_banks);
   p.code_jitter = std::make_unique<CodeJitter>();
   j.at("code_jitter").get_to(*p.code_jitter);
@@ -308,19 +346,14 @@ std::string &PatternAddressMapper::get_instance_id() {
   return instance_id;
 }
 
-const std::unordered_set<volatile char *> &PatternAddressMapper::get_victim_rows() const {
+const std::vector<DRAMAddr> &PatternAddressMapper::get_victim_rows() const {
   return victim_rows;
 }
 
-std::vector<volatile char *> PatternAddressMapper::get_random_nonaccessed_rows(int row_upper_bound) {
-  // we don't mind if addresses are added multiple times
-  std::vector<volatile char *> addresses;
-  for (int i = 0; i < 1024; ++i) {
-    auto row_no = Range<int>(max_row, max_row + min_row).get_random_number(gen)%row_upper_bound;
-    addresses.push_back(
-        static_cast<volatile char*>(DRAMAddr(static_cast<size_t>(bank_no), static_cast<size_t>(row_no), 0).to_virt()));
-  }
-  return addresses;
+RandomBankRows PatternAddressMapper::get_random_nonaccessed_rows(int row_upper_bound) {
+  // we don't mind if addresses are visited multiple times
+  return {*ctx, static_cast<size_t>(bank_no), page_no, max_row, max_row + min_row,
+          static_cast<size_t>(row_upper_bound), 1024, gen()};
 }
 
 void PatternAddressMapper::shift_mapping(int rows, const std::unordered_set<AggressorAccessPattern> &aggs_to_move) {
@@ -355,13 +388,17 @@ CodeJitter &PatternAddressMapper::get_code_jitter() const {
 PatternAddressMapper::PatternAddressMapper(const PatternAddressMapper &other)
     : victim_rows(other.victim_rows),
       instance_id(other.instance_id),
+      ctx(other.ctx),
       min_row(other.min_row),
       max_row(other.max_row),
       bank_no(other.bank_no),
+      page_no(other.page_no),
       aggressor_to_addr(other.aggressor_to_addr),
       bit_flips(other.bit_flips),
       corrected_bit_flips(other.corrected_bit_flips),
       reproducibility_score(other.reproducibility_score),
+      data_pattern(other.data_pattern),
+      data_seed(other.data_seed),
       total_banks(other.total_banks) {
   code_jitter = std::make_unique<CodeJitter>();
   code_jitter->num_aggs_for_sync = other.get_code_jitter().num_aggs_for_sync;
@@ -378,6 +415,7 @@ PatternAddressMapper &PatternAddressMapper::operator=(const PatternAddressMapper
   victim_rows = other.victim_rows;
   instance_id = other.instance_id;
   gen = other.gen;
+  ctx = other.ctx;
 
   code_jitter = std::make_unique<CodeJitter>();
   code_jitter->num_aggs_for_sync = other.get_code_jitter().num_aggs_for_sync;
@@ -389,11 +427,15 @@ PatternAddressMapper &PatternAddressMapper::operator=(const PatternAddressMapper
   min_row = other.min_row;
   max_row = other.max_row;
   bank_no = other.bank_no;
+  page_no = other.page_no;
 
   aggressor_to_addr = other.aggressor_to_addr;
   bit_flips = other.bit_flips;
   corrected_bit_flips = other.corrected_bit_flips;
   reproducibility_score = other.reproducibility_score;
+  data_pattern = other.data_pattern;
+  data_seed = other.data_seed;
+  total_banks = other.total_banks;
 
   return *this;
 }
@@ -454,8 +496,9 @@ void PatternAddressMapper::remap_aggressors(DRAMAddr &new_location) {
 
   // now update each mapping's address
   for (auto &[id, addr]: aggressor_to_addr) {
-    // we just overwrite the bank
+    // we just overwrite the bank and superpage
     addr.bank = new_location.bank;
+    addr.page = new_location.page;
     // for the row, we need to shift accordingly to preserve the distances between aggressors
     addr.row += offset;
   }
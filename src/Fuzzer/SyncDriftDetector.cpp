@@ -0,0 +1,41 @@
+#include "Fuzzer/SyncDriftDetector.hpp"
+
+#include <cmath>
+
+SyncDriftDetector::SyncDriftDetector(size_t window_size, double max_relative_drift, double min_significance)
+    : window_size(window_size), max_relative_drift(max_relative_drift), min_significance(min_significance) {
+}
+
+void SyncDriftDetector::add(double sync_rounds) {
+  if (baseline.get_count() < window_size) {
+    baseline.add(sync_rounds);
+    return;
+  }
+  window.push_back(sync_rounds);
+  if (window.size() > window_size) window.pop_front();
+}
+
+bool SyncDriftDetector::has_drifted() const {
+  if (window.size() < window_size) return false;
+  RunningStats current;
+  for (const auto value : window) current.add(value);
+
+  const double drift = std::abs(current.get_mean() - baseline.get_mean());
+  if (drift <= max_relative_drift*baseline.get_mean()) return false;
+  // the standard error of the difference between the two means (Welch)
+  const double std_error = std::sqrt(baseline.get_variance()/static_cast<double>(baseline.get_count())
+                                         + current.get_variance()/static_cast<double>(current.get_count()));
+  return std_error==0 || drift >= min_significance*std_error;
+}
+
+void SyncDriftDetector::reset() {
+  baseline.clear();
+  window.clear();
+}
+
+double SyncDriftDetector::get_window_mean() const {
+  if (window.empty()) return 0;
+  double sum = 0;
+  for (const auto value : window) sum += value;
+  return sum/static_cast<double>(window.size());
+}
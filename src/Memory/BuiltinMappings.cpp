@@ -0,0 +1,24 @@
+#include "Memory/BuiltinMappings.hpp"
+
+namespace {
+
+// the generated file lists one BUILTIN_MAPPING(identifier, name, #bank bits, #col bits, #row bits, {DRAM_MTX}) per config
+#define BUILTIN_MAPPING(identifier, name, bank_bits, col_bits, row_bits, ...) \
+  constexpr mapping_matrix identifier##_dram = __VA_ARGS__; \
+  constexpr mapping_matrix identifier##_addr = invert_gf2(identifier##_dram); \
+  static_assert(identifier##_addr[0]!=0, "the matrix of config " name " is not invertible");
+#include "BuiltinMappings.inc"
+#undef BUILTIN_MAPPING
+
+}
+
+const std::vector<BuiltinMapping> &get_builtin_mappings() {
+  static const std::vector<BuiltinMapping> mappings = {
+#define BUILTIN_MAPPING(identifier, name, bank_bits, col_bits, row_bits, ...) \
+    {name, bank_bits, col_bits, row_bits, &identifier##_dram, &identifier##_addr, \
+     apply_builtin_matrix<identifier##_dram>, apply_builtin_matrix<identifier##_addr>},
+#include "BuiltinMappings.inc"
+#undef BUILTIN_MAPPING
+  };
+  return mappings;
+}
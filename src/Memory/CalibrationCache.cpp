@@ -0,0 +1,139 @@
+#include "Memory/CalibrationCache.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+#include "Utilities/CpuTopology.hpp"
+#include "Utilities/Logger.hpp"
+
+void to_json(nlohmann::json &j, const Calibration &c) {
+  j = nlohmann::json{{"conflict_threshold", c.conflict_threshold},
+                     {"bank_thresholds", c.bank_thresholds},
+                     {"acts_per_trefi", c.acts_per_trefi},
+                     {"config_checked", c.config_checked},
+                     {"config_mismatch_rate", c.config_mismatch_rate},
+                     {"refresh_profile", c.refresh_profile}
+  };
+}
+
+void from_json(const nlohmann::json &j, Calibration &c) {
+  j.at("conflict_threshold").get_to(c.conflict_threshold);
+  j.at("bank_thresholds").get_to(c.bank_thresholds);
+  j.at("acts_per_trefi").get_to(c.acts_per_trefi);
+  j.at("config_checked").get_to(c.config_checked);
+  j.at("config_mismatch_rate").get_to(c.config_mismatch_rate);
+  if (j.contains("refresh_profile")) j.at("refresh_profile").get_to(c.refresh_profile);
+}
+
+CalibrationCache::CalibrationCache(const std::string &filepath, const BlacksmithConfig &config)
+    : filepath(filepath), config_hash(hash_config(config)), cpu_model(CpuTopology::get_cpu_info("model name")),
+      microcode(CpuTopology::get_cpu_info("microcode")), dimm_serials(get_dimm_serials()) {
+  char name[256] = {};
+  gethostname(name, sizeof(name) - 1);
+  hostname = name;
+  if (dimm_serials.empty())
+    Logger::log_debug("Could not read the DIMM serial numbers, the calibration cache does not notice swapped DIMMs.");
+
+  contents = {{"entries", nlohmann::json::array()}};
+  std::ifstream is(filepath);
+  if (!is) return;
+  try {
+    nlohmann::json j;
+    is >> j;
+    if (j.contains("entries") && j["entries"].is_array()) contents = j;
+  } catch (const nlohmann::json::exception &e) {
+    Logger::log_error(format_string("Ignoring the malformed calibration cache %s: %s", filepath.c_str(), e.what()));
+  }
+}
+
+std::string CalibrationCache::hash_config(const BlacksmithConfig &config) {
+  // nlohmann::json sorts the keys of objects, so the dump does not depend on the order of the keys in the config file
+  const std::string dump = nlohmann::json(config).dump();
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const auto c : dump) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return format_string("%016lx", hash);
+}
+
+std::vector<std::string> CalibrationCache::get_dimm_serials() {
+  const std::string dmi_dir = "/sys/firmware/dmi/entries";
+  std::vector<std::string> serials;
+  DIR *dir = opendir(dmi_dir.c_str());
+  if (dir==nullptr) return serials;
+
+  for (struct dirent *entry = readdir(dir); entry!=nullptr; entry = readdir(dir)) {
+    // the entries of type 17 (memory device) are named 17-0, 17-1, ...
+    const std::string name = entry->d_name;
+    if (name.compare(0, 3, "17-")!=0) continue;
+    std::ifstream is(dmi_dir + "/" + name + "/raw", std::ios::binary);
+    const std::vector<uint8_t> raw((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    // the formatted part of the entry starts with its type and length, the size of the device is at offset 0x0C (0
+    // if the slot is empty), and the serial number is given at offset 0x18 as the index of a string; the strings
+    // follow the formatted part, each terminated by a null byte
+    if (raw.size() < 0x19 || raw[0]!=17 || raw[1] <= 0x18 || raw[1] > raw.size()) continue;
+    if (raw[0x0C]==0 && raw[0x0D]==0) continue;
+    const size_t serial_index = raw[0x18];
+    if (serial_index==0) continue;
+    size_t pos = raw[1];
+    for (size_t i = 1; i < serial_index && pos < raw.size(); ++i) {
+      while (pos < raw.size() && raw[pos]!=0) pos++;
+      pos++;
+    }
+    std::string serial;
+    while (pos < raw.size() && raw[pos]!=0) serial += static_cast<char>(raw[pos++]);
+    if (!serial.empty()) serials.push_back(serial);
+  }
+  closedir(dir);
+
+  std::sort(serials.begin(), serials.end());
+  return serials;
+}
+
+bool CalibrationCache::matches(const nlohmann::json &entry) const {
+  return entry.value("hostname", "")==hostname
+      && entry.value("config_hash", "")==config_hash
+      && entry.value("cpu_model", "")==cpu_model
+      && entry.value("microcode", "")==microcode
+      && entry.value("dimm_serials", std::vector<std::string>())==dimm_serials;
+}
+
+bool CalibrationCache::lookup(Calibration &calibration) const {
+  for (const auto &entry : contents.at("entries")) {
+    if (!matches(entry)) continue;
+    try {
+      calibration = entry.at("calibration").get<Calibration>();
+      return true;
+    } catch (const nlohmann::json::exception &) {
+      return false;
+    }
+  }
+  return false;
+}
+
+void CalibrationCache::store(const Calibration &calibration) {
+  auto &entries = contents["entries"];
+  for (auto it = entries.begin(); it!=entries.end();) {
+    it = matches(*it) ? entries.erase(it) : std::next(it);
+  }
+  entries.push_back({{"hostname", hostname},
+                     {"config_hash", config_hash},
+                     {"cpu_model", cpu_model},
+                     {"microcode", microcode},
+                     {"dimm_serials", dimm_serials},
+                     {"timestamp", static_cast<int64_t>(time(nullptr))},
+                     {"calibration", calibration}});
+
+  std::ofstream os(filepath);
+  if (!os) {
+    Logger::log_error(format_string("Could not write the calibration cache %s.", filepath.c_str()));
+    return;
+  }
+  os << contents.dump(2) << std::endl;
+}
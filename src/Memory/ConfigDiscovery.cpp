@@ -0,0 +1,288 @@
+#include "Memory/ConfigDiscovery.hpp"
+
+#include <algorithm>
+
+#include "GlobalDefines.hpp"
+#include "Memory/DRAMAddr.hpp"
+#include "Utilities/GF2Matrix.hpp"
+#include "Utilities/Logger.hpp"
+#include "Utilities/ThresholdCalibrator.hpp"
+#include "Utilities/TimeHelper.hpp"
+
+// the offsets within a superpage and the offsets of whole cache lines among them
+#define SUPERPAGE_MASK ((1ULL << SUPERPAGE_BITS) - 1)
+#define LINE_OFFSET_MASK (SUPERPAGE_MASK & ~(CACHELINE_SIZE - 1))
+
+ConfigDiscovery::ConfigDiscovery(volatile char *superpage, TimingSource &timing, uint64_t seed)
+    : superpage(superpage), timing(timing), gen(seed) {
+}
+
+uint64_t ConfigDiscovery::measure_diff(uint64_t diff) {
+  const uint64_t offset = gen() & LINE_OFFSET_MASK;
+  num_measurements++;
+  return timing.measure(superpage + offset, superpage + (offset ^ diff));
+}
+
+bool ConfigDiscovery::is_conflict(uint64_t diff, size_t rounds, size_t required) {
+  size_t conflicts = 0;
+  for (size_t i = 0; i < rounds; ++i) {
+    if (measure_diff(diff) > threshold) conflicts++;
+    // stop as soon as enough conflicts were seen or there are too few measurements left to reach them
+    if (conflicts >= required) return true;
+    if (conflicts + (rounds - i - 1) < required) return false;
+  }
+  return false;
+}
+
+uint64_t ConfigDiscovery::reduce(uint64_t v) const {
+  for (size_t bit = SUPERPAGE_BITS; bit-- > 0;) {
+    if ((v & (1ULL << bit)) && same_bank_basis[bit]!=0) v ^= same_bank_basis[bit];
+  }
+  return v;
+}
+
+bool ConfigDiscovery::determine_threshold() {
+  Logger::log_progress("Determining row conflict threshold...");
+
+  // most random pairs are in different banks, only about one in (number of banks) conflicts
+  ThresholdCalibrator calibrator;
+  bool separated = false;
+  while (!separated && calibrator.get_num_samples() < THRESHOLD_MAX_SAMPLES) {
+    for (size_t i = 0; i < THRESHOLD_BATCH; ++i) {
+      uint64_t diff;
+      do {
+        diff = gen() & LINE_OFFSET_MASK;
+      } while (diff==0);
+      calibrator.add(measure_diff(diff));
+    }
+    separated = calibrator.get_num_samples() >= THRESHOLD_MIN_SAMPLES && calibrator.is_separated();
+  }
+  threshold = calibrator.get_threshold();
+
+  Logger::delete_stdout_line();
+  Logger::log_info(format_string("Determined row conflict threshold to be %zu (%zu of %zu random pairs conflict).",
+      threshold, calibrator.get_slow_count(), calibrator.get_num_samples()));
+  // with at least two banks, at most half of all pairs can be in the same bank
+  return separated && calibrator.get_slow_count() <= calibrator.get_num_samples()/2;
+}
+
+bool ConfigDiscovery::find_same_bank_differences() {
+  Logger::log_progress("Collecting same-bank differences...");
+
+  // the offsets within a cache line never change the bank
+  same_bank_basis = {};
+  for (size_t bit = 0; bit < CACHELINE_BITS; ++bit) same_bank_basis[bit] = 1ULL << bit;
+  same_bank_dims = CACHELINE_BITS;
+
+  size_t stable = 0;
+  for (size_t i = 0; i < MAX_CANDIDATES && stable < STABLE_CONFLICTS; ++i) {
+    const uint64_t diff = gen() & LINE_OFFSET_MASK;
+    // a single measurement suffices to skip a candidate, most are in different banks
+    if (diff==0 || !is_conflict(diff, 1, 1)) continue;
+
+    const uint64_t reduced = reduce(diff);
+    if (reduced==0) {
+      stable++;
+      continue;
+    }
+    if (!is_conflict(diff, CONFIRM_VOTES, CONFIRM_VOTES)) continue;
+    same_bank_basis[63 - __builtin_clzll(reduced)] = reduced;
+    same_bank_dims++;
+    stable = 0;
+    Logger::delete_stdout_line();
+    Logger::log_progress(format_string("Collecting same-bank differences (%zu dimensions)...", same_bank_dims));
+  }
+
+  Logger::delete_stdout_line();
+  Logger::log_info(format_string("Found a %zu-dimensional subspace of same-bank differences.", same_bank_dims));
+  return stable >= STABLE_CONFLICTS;
+}
+
+std::vector<uint64_t> ConfigDiscovery::solve_bank_functions() const {
+  // the bank functions are all functions that are 0 for every same-bank difference
+  GF2Matrix differences(same_bank_dims, SUPERPAGE_BITS);
+  size_t r = 0;
+  for (const auto &v : same_bank_basis) {
+    if (v!=0) differences.set_row(r++, v);
+  }
+  const GF2Matrix functions = differences.nullspace();
+  const size_t num_functions = functions.get_num_rows();
+
+  // any basis of the functions describes the same banks, so pick the one that is easiest to read: enumerate all
+  // combinations of the functions and greedily keep those with the fewest bits that are linearly independent
+  std::vector<uint64_t> combinations;
+  for (uint64_t mask = 1; mask < (1ULL << num_functions); ++mask) {
+    uint64_t f = 0;
+    for (size_t i = 0; i < num_functions; ++i) {
+      if (mask & (1ULL << i)) f ^= functions.get_row(i);
+    }
+    combinations.push_back(f);
+  }
+  std::sort(combinations.begin(), combinations.end(), [](uint64_t a, uint64_t b) {
+    const int pa = __builtin_popcountll(a), pb = __builtin_popcountll(b);
+    return pa < pb || (pa==pb && a < b);
+  });
+
+  std::vector<uint64_t> result;
+  std::array<uint64_t, SUPERPAGE_BITS> basis{};
+  for (auto f : combinations) {
+    uint64_t v = f;
+    for (size_t bit = SUPERPAGE_BITS; bit-- > 0;) {
+      if ((v & (1ULL << bit)) && basis[bit]!=0) v ^= basis[bit];
+    }
+    if (v==0) continue;
+    basis[63 - __builtin_clzll(v)] = v;
+    result.push_back(f);
+    if (result.size()==num_functions) break;
+  }
+  // list the functions by their lowest bit, like the configs in config/
+  std::sort(result.begin(), result.end(), [](uint64_t a, uint64_t b) {
+    return __builtin_ctzll(a) < __builtin_ctzll(b) || (__builtin_ctzll(a)==__builtin_ctzll(b) && a < b);
+  });
+  return result;
+}
+
+std::vector<size_t> ConfigDiscovery::find_row_bits(const std::vector<uint64_t> &bank_functions) {
+  Logger::log_progress("Determining row bits...");
+
+  GF2Matrix functions(bank_functions.size(), SUPERPAGE_BITS);
+  for (size_t i = 0; i < bank_functions.size(); ++i) functions.set_row(i, bank_functions[i]);
+
+  // each basis vector of the nullspace is a single bit plus the lowest bits of the bank functions that contain it
+  // (see GF2Matrix::nullspace), which keep the bank unchanged; these are never row bits as rows use the upper bits, so
+  // the difference conflicts iff its highest bit is a row bit
+  const GF2Matrix same_bank = functions.nullspace();
+  std::vector<size_t> row_bits;
+  for (size_t i = 0; i < same_bank.get_num_rows(); ++i) {
+    const uint64_t diff = same_bank.get_row(i);
+    const auto bit = static_cast<size_t>(63 - __builtin_clzll(diff));
+    if (bit < CACHELINE_BITS) continue;
+    if (is_conflict(diff, ROW_VOTES, ROW_VOTES/2 + 1)) row_bits.push_back(bit);
+  }
+  std::sort(row_bits.rbegin(), row_bits.rend());
+
+  Logger::delete_stdout_line();
+  return row_bits;
+}
+
+bool ConfigDiscovery::validate(const BlacksmithConfig &config) {
+  Logger::log_progress("Validating the discovered mapping...");
+
+  const TranslationContext ctx(config, superpage, 1);
+  std::uniform_int_distribution<size_t> bank_dist(0, ctx.get_bank_count() - 1);
+  std::uniform_int_distribution<size_t> row_dist(0, ctx.get_row_count() - 1);
+  std::uniform_int_distribution<size_t> col_dist(0, ctx.get_mem_config().COL_MASK);
+
+  // same bank and different row must conflict, same row or different bank must not
+  const char *kinds[] = {"same bank, different row", "same row", "different bank"};
+  bool valid = true;
+  for (size_t kind = 0; kind < 3; ++kind) {
+    size_t agreements = 0;
+    for (size_t i = 0; i < VALIDATION_PAIRS; ++i) {
+      const DRAMAddr a(ctx, bank_dist(gen), row_dist(gen), col_dist(gen), 0);
+      DRAMAddr b = a;
+      if (kind==0) {
+        while (b.row==a.row) b.row = row_dist(gen);
+      } else if (kind==1) {
+        // the second address must not be in the same cache line
+        while ((size_t) b.to_virt()/CACHELINE_SIZE==(size_t) a.to_virt()/CACHELINE_SIZE) b.col = col_dist(gen);
+      } else {
+        while (b.bank==a.bank) b.bank = bank_dist(gen);
+        b.row = row_dist(gen);
+      }
+      num_measurements++;
+      const bool conflict = timing.measure((volatile char *) a.to_virt(), (volatile char *) b.to_virt()) > threshold;
+      if (conflict==(kind==0)) agreements++;
+    }
+    const double agreement = static_cast<double>(agreements)/VALIDATION_PAIRS;
+    Logger::delete_stdout_line();
+    Logger::log_data(format_string("Validation (%s): %zu of %zu pairs as expected.", kinds[kind], agreements,
+        VALIDATION_PAIRS));
+    if (agreement < VALIDATION_MIN_AGREEMENT) valid = false;
+  }
+  return valid;
+}
+
+BlacksmithConfig ConfigDiscovery::discover(const std::string &name) {
+  const auto start_ts = get_timestamp_us();
+
+  if (!determine_threshold()) {
+    Logger::log_error("Could not tell row conflicts apart from other accesses.");
+    exit(EXIT_FAILURE);
+  }
+  if (!find_same_bank_differences()) {
+    Logger::log_error(format_string("The same-bank differences did not converge after %zu candidates.",
+        MAX_CANDIDATES));
+    exit(EXIT_FAILURE);
+  }
+
+  const auto bank_functions = solve_bank_functions();
+  if (bank_functions.empty()) {
+    Logger::log_error("Found no bank functions, all random pairs seemed to be in the same bank.");
+    exit(EXIT_FAILURE);
+  }
+  const auto row_bits = find_row_bits(bank_functions);
+  if (row_bits.empty()) {
+    Logger::log_error("Found no row bits.");
+    exit(EXIT_FAILURE);
+  }
+
+  // all other bits are column bits, except for as many as there are bank functions: those are only determined by the
+  // bank functions (e.g., bits 13 to 17 in coffee-lake-1-1-2-32.json); pick the highest bits for which the functions
+  // are still independent, so that the column bits are the lowest ones
+  std::vector<size_t> col_bits;
+  uint64_t bank_only = 0;
+  size_t bank_only_rank = 0;
+  for (size_t bit = SUPERPAGE_BITS; bit-- > 0;) {
+    if (std::find(row_bits.begin(), row_bits.end(), bit)!=row_bits.end()) continue;
+    if (bank_only_rank < bank_functions.size() && bit >= CACHELINE_BITS) {
+      GF2Matrix restricted(bank_functions.size(), SUPERPAGE_BITS);
+      for (size_t i = 0; i < bank_functions.size(); ++i) {
+        restricted.set_row(i, bank_functions[i] & (bank_only | (1ULL << bit)));
+      }
+      if (restricted.rank() > bank_only_rank) {
+        bank_only |= 1ULL << bit;
+        bank_only_rank++;
+        continue;
+      }
+    }
+    col_bits.push_back(bit);
+  }
+  if (bank_only_rank < bank_functions.size()) {
+    Logger::log_error("The bank functions cannot be told apart without the row bits, the row bits may be wrong.");
+    exit(EXIT_FAILURE);
+  }
+
+  BlacksmithConfig config;
+  config.name = name;
+  // the timing does not tell which bank functions select the channel, DIMM, or rank
+  config.channels = 1;
+  config.dimms = 1;
+  config.ranks = 1;
+  config.total_banks = 1ULL << bank_functions.size();
+  for (auto bit : row_bits) config.row_bits.emplace_back(static_cast<uint64_t>(bit));
+  for (auto bit : col_bits) config.col_bits.emplace_back(static_cast<uint64_t>(bit));
+  for (auto f : bank_functions) {
+    std::vector<uint64_t> bits;
+    for (size_t bit = 0; bit < SUPERPAGE_BITS; ++bit) {
+      if (f & (1ULL << bit)) bits.push_back(bit);
+    }
+    if (bits.size()==1) {
+      config.bank_bits.emplace_back(bits.front());
+    } else {
+      config.bank_bits.emplace_back(bits);
+    }
+  }
+
+  Logger::log_info(format_string("Found %zu bank functions, %zu row bits, and %zu column bits.",
+      bank_functions.size(), row_bits.size(), col_bits.size()));
+  Logger::log_data(nlohmann::json(config).dump());
+
+  if (!validate(config)) {
+    Logger::log_error("The discovered mapping does not match the measured timings. Is the system idle?");
+    exit(EXIT_FAILURE);
+  }
+  Logger::log_info(format_string("Discovered and validated the mapping with %zu measurements in %ld s.",
+      num_measurements, (get_timestamp_us() - start_ts)/1000000));
+  return config;
+}
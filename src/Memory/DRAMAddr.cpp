@@ -1,41 +1,34 @@
 #include "Memory/DRAMAddr.hpp"
 
+#include <algorithm>
 
-void DRAMAddr::initialize(volatile char *start_address) {
-  DRAMAddr::set_base_msb((void *) start_address);
-}
-
-void DRAMAddr::set_base_msb(void *buff) {
-  base_msb = (size_t) buff & (~((size_t) (1ULL << 30UL) - 1UL));  // get higher order bits above the super page
-}
-
-void DRAMAddr::set_config(BlacksmithConfig &config) {
-  Config = &config;
-  MemConfig = config.to_memconfig();
-}
+#include "GlobalDefines.hpp"
+#include "Memory/DramGeometry.hpp"
 
 DRAMAddr::DRAMAddr() = default;
 
-DRAMAddr::DRAMAddr(size_t bk, size_t r, size_t c) {
+DRAMAddr::DRAMAddr(const TranslationContext &ctx, size_t bk, size_t r, size_t c, size_t pg) : ctx(&ctx) {
   bank = bk;
   row = r;
   col = c;
+  page = pg;
 }
 
-DRAMAddr::DRAMAddr(void *addr) {
+DRAMAddr::DRAMAddr(const TranslationContext &ctx, void *addr) : ctx(&ctx) {
   auto p = (size_t) addr;
-  size_t res = 0;
-  for (unsigned long i : MemConfig.DRAM_MTX) {
-    res <<= 1ULL;
-    res |= (size_t) __builtin_parityl(p & i);
-  }
-  bank = (res >> MemConfig.BK_SHIFT) & MemConfig.BK_MASK;
-  row = (res >> MemConfig.ROW_SHIFT) & MemConfig.ROW_MASK;
-  col = (res >> MemConfig.COL_SHIFT) & MemConfig.COL_MASK;
+  // the superpages of the pool are contiguous, the mapping function is applied within each of them
+  page = (p - ctx.get_base_msb())/HUGEPAGE_SIZE;
+  size_t res = ctx.to_dram(p);
+  const auto &mem_config = ctx.get_mem_config();
+  bank = ctx.compress_bank((res >> mem_config.BK_SHIFT) & mem_config.BK_MASK);
+  row = (res >> mem_config.ROW_SHIFT) & mem_config.ROW_MASK;
+  col = (res >> mem_config.COL_SHIFT) & mem_config.COL_MASK;
 }
 
 size_t DRAMAddr::linearize() const {
-  return (this->bank << MemConfig.BK_SHIFT) | (this->row << MemConfig.ROW_SHIFT) | (this->col << MemConfig.COL_SHIFT);
+  const auto &mem_config = context().get_mem_config();
+  return (ctx->expand_bank(this->bank) << mem_config.BK_SHIFT) | (this->row << mem_config.ROW_SHIFT)
+      | (this->col << mem_config.COL_SHIFT);
 }
 
 void *DRAMAddr::to_virt() {
@@ -43,37 +36,89 @@ void *DRAMAddr::to_virt() {
 }
 
 void *DRAMAddr::to_virt() const {
-  size_t res = 0;
-  size_t l = this->linearize();
-  for (unsigned long i : MemConfig.ADDR_MTX) {
-    res <<= 1ULL;
-    res |= (size_t) __builtin_parityl(l & i);
-  }
-  void *v_addr = (void *) (base_msb | res);
+  size_t res = context().to_addr(this->linearize());
+  void *v_addr = (void *) ((ctx->get_base_msb() + this->page*HUGEPAGE_SIZE) | res);
   return v_addr;
 }
 
+bool DRAMAddr::get_absolute(size_t &abs_bank, size_t &abs_row, size_t &abs_col) const {
+  size_t origin;
+  if (!context().get_page_origin(page, origin)) return false;
+  // the mapping is linear, so the superpage's origin just needs to be added to the coordinates within the superpage
+  const size_t res = linearize() ^ origin;
+  const auto &mem_config = ctx->get_mem_config();
+  abs_bank = (res >> mem_config.BK_SHIFT) & mem_config.BK_MASK;
+  abs_row = (res >> mem_config.ROW_SHIFT) & mem_config.ROW_MASK;
+  abs_col = (res >> mem_config.COL_SHIFT) & mem_config.COL_MASK;
+  return true;
+}
+
+size_t DRAMAddr::get_absolute_bank() const {
+  size_t abs_bank, abs_row, abs_col;
+  if (context().is_wide() && get_absolute(abs_bank, abs_row, abs_col)) return abs_bank;
+  return ctx->expand_bank(bank);
+}
+
+size_t DRAMAddr::get_channel() const {
+  return context().get_bank_label(get_absolute_bank(), BankLabel::CHANNEL);
+}
+
+size_t DRAMAddr::get_dimm() const {
+  return context().get_bank_label(get_absolute_bank(), BankLabel::DIMM);
+}
+
+size_t DRAMAddr::get_rank() const {
+  return context().get_bank_label(get_absolute_bank(), BankLabel::RANK);
+}
+
+size_t DRAMAddr::get_bank_group() const {
+  return context().get_bank_label(get_absolute_bank(), BankLabel::BANK_GROUP);
+}
+
+std::string DRAMAddr::get_dimm_name() const {
+  const size_t abs_bank = get_absolute_bank();
+  return format_string("channel %zu, DIMM %zu",
+      context().get_bank_label(abs_bank, BankLabel::CHANNEL),
+      ctx->get_bank_label(abs_bank, BankLabel::DIMM));
+}
+
 std::string DRAMAddr::to_string() {
   char buff[1024];
-  sprintf(buff, "DRAMAddr(b: %zu, r: %zu, c: %zu) = %p",
+  int len = sprintf(buff, "DRAMAddr(p: %zu, b: %zu, r: %zu, c: %zu)",
+      this->page,
       this->bank,
       this->row,
-      this->col,
-      this->to_virt());
+      this->col);
+  // addresses deserialized from JSON have no context to translate them with
+  if (ctx==nullptr) return std::string(buff);
+  len += sprintf(buff + len, " = %p", this->to_virt());
+  size_t abs_bank, abs_row, abs_col;
+  if (ctx->is_wide() && get_absolute(abs_bank, abs_row, abs_col)) {
+    sprintf(buff + len, " (absolute b: %zu, r: %zu, c: %zu)", abs_bank, abs_row, abs_col);
+  }
   return std::string(buff);
 }
 
 std::string DRAMAddr::to_string_compact() const {
   char buff[1024];
-  sprintf(buff, "(%ld,%ld,%ld)",
-      this->bank,
-      this->row,
-      this->col);
+  // only mention the superpage if there is more than one, otherwise it is always 0
+  if (ctx!=nullptr && ctx->get_page_count() > 1) {
+    sprintf(buff, "(%ld,%ld,%ld,%ld)",
+        this->page,
+        this->bank,
+        this->row,
+        this->col);
+  } else {
+    sprintf(buff, "(%ld,%ld,%ld)",
+        this->bank,
+        this->row,
+        this->col);
+  }
   return std::string(buff);
 }
 
 DRAMAddr DRAMAddr::add(size_t bank_increment, size_t row_increment, size_t column_increment) const {
-  return {bank + bank_increment, row + row_increment, col + column_increment};
+  return {context(), bank + bank_increment, row + row_increment, col + column_increment, page};
 }
 
 void DRAMAddr::add_inplace(size_t bank_increment, size_t row_increment, size_t column_increment) {
@@ -82,30 +127,56 @@ void DRAMAddr::add_inplace(size_t bank_increment, size_t row_increment, size_t c
   col += column_increment;
 }
 
-// Define the static DRAM configs
-BlacksmithConfig *DRAMAddr::Config;
-MemConfiguration DRAMAddr::MemConfig;
-size_t DRAMAddr::base_msb;
-
-#ifdef ENABLE_JSON
+void DRAMAddr::get_row_lines(std::vector<volatile char *> &lines) const {
+  const RowLines row_lines(*this);
+  lines.reserve(lines.size() + row_lines.size());
+  lines.insert(lines.end(), row_lines.begin(), row_lines.end());
+}
 
-nlohmann::json DRAMAddr::get_memcfg_json() {
-  nlohmann::json j;
-  j["channels"] = Config->channels;
-  j["dimms"] = Config->dimms;
-  j["ranks"] = Config->ranks;
-  j["banks"] = Config->total_banks;
-  return j;
+void DRAMAddr::from_virt_batch(const TranslationContext &ctx, volatile char *const *addrs, size_t n,
+                               DRAMAddr *out) {
+  const auto &mem_config = ctx.get_mem_config();
+  // translate in chunks so that the intermediate results stay on the stack
+  size_t in[64], res[64];
+  for (size_t first = 0; first < n; first += 64) {
+    const size_t count = std::min(n - first, (size_t) 64);
+    for (size_t i = 0; i < count; ++i) in[i] = (size_t) addrs[first + i];
+    ctx.to_dram_batch(in, res, count);
+    for (size_t i = 0; i < count; ++i) {
+      auto &addr = out[first + i];
+      addr.ctx = &ctx;
+      addr.page = (in[i] - ctx.get_base_msb())/HUGEPAGE_SIZE;
+      addr.bank = ctx.compress_bank((res[i] >> mem_config.BK_SHIFT) & mem_config.BK_MASK);
+      addr.row = (res[i] >> mem_config.ROW_SHIFT) & mem_config.ROW_MASK;
+      addr.col = (res[i] >> mem_config.COL_SHIFT) & mem_config.COL_MASK;
+    }
+  }
 }
 
-#endif
+void DRAMAddr::to_virt_batch(const TranslationContext &ctx, const DRAMAddr *addrs, size_t n, volatile char **out) {
+  const auto &mem_config = ctx.get_mem_config();
+  size_t in[64], res[64];
+  for (size_t first = 0; first < n; first += 64) {
+    const size_t count = std::min(n - first, (size_t) 64);
+    for (size_t i = 0; i < count; ++i) {
+      const auto &addr = addrs[first + i];
+      in[i] = (ctx.expand_bank(addr.bank) << mem_config.BK_SHIFT) | (addr.row << mem_config.ROW_SHIFT)
+          | (addr.col << mem_config.COL_SHIFT);
+    }
+    ctx.to_addr_batch(in, res, count);
+    for (size_t i = 0; i < count; ++i) {
+      out[first + i] = (volatile char *) ((ctx.get_base_msb() + addrs[first + i].page*HUGEPAGE_SIZE) | res[i]);
+    }
+  }
+}
 
 #ifdef ENABLE_JSON
 
 void to_json(nlohmann::json &j, const DRAMAddr &p) {
   j = {{"bank", p.bank},
        {"row", p.row},
-       {"col", p.col}
+       {"col", p.col},
+       {"page", p.page}
   };
 }
 
@@ -113,6 +184,12 @@ void from_json(const nlohmann::json &j, DRAMAddr &p) {
   j.at("bank").get_to(p.bank);
   j.at("row").get_to(p.row);
   j.at("col").get_to(p.col);
+  // to preserve backward-compatibility
+  if (j.contains("page")) {
+    j.at("page").get_to(p.page);
+  } else {
+    p.page = 0;
+  }
 }
 
 #endif
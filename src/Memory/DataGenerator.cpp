@@ -0,0 +1,89 @@
+#include "Memory/DataGenerator.hpp"
+
+#include <immintrin.h>
+
+const DataGenerator::fill_fn DataGenerator::fill_kernel = DataGenerator::select_kernel();
+
+DataGenerator::DataGenerator(uint64_t seed) : seed(seed) {
+}
+
+DataGenerator::fill_fn DataGenerator::select_kernel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) return fill_avx512;
+  if (__builtin_cpu_supports("avx2")) return fill_avx2;
+  return fill_scalar;
+}
+
+void DataGenerator::fill(uint64_t offset, char *dst, size_t len, bool non_temporal) const {
+  fill_kernel(seed, offset, dst, len, non_temporal);
+  // streaming stores are weakly ordered, make them globally visible before anyone reads the data
+  if (non_temporal) _mm_sfence();
+}
+
+void DataGenerator::fill_scalar(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal) {
+  auto words = (uint64_t *) dst;
+  const uint64_t first_index = offset/sizeof(uint64_t);
+  for (size_t i = 0; i < len/sizeof(uint64_t); ++i) {
+    if (non_temporal) {
+      _mm_stream_si64((long long *) &words[i], (long long) hash(seed, first_index + i));
+    } else {
+      words[i] = hash(seed, first_index + i);
+    }
+  }
+}
+
+// AVX2 has no 64-bit low multiply, so it is composed of three 32x32->64 bit multiplications
+__attribute__((target("avx2")))
+static inline __m256i mullo_epi64_avx2(__m256i a, __m256i b) {
+  __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                   _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2")))
+void DataGenerator::fill_avx2(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal) {
+  const __m256i golden = _mm256_set1_epi64x((long long) 0x9E3779B97F4A7C15ULL);
+  const __m256i m1 = _mm256_set1_epi64x((long long) 0xBF58476D1CE4E5B9ULL);
+  const __m256i m2 = _mm256_set1_epi64x((long long) 0x94D049BB133111EBULL);
+  const __m256i vseed = _mm256_set1_epi64x((long long) seed);
+  const __m256i step = _mm256_set1_epi64x(4);
+  const auto first_index = (long long) (offset/sizeof(uint64_t));
+  __m256i index = _mm256_setr_epi64x(first_index, first_index + 1, first_index + 2, first_index + 3);
+
+  for (size_t i = 0; i < len; i += sizeof(__m256i)) {
+    __m256i z = _mm256_xor_si256(vseed, mullo_epi64_avx2(index, golden));
+    z = mullo_epi64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)), m1);
+    z = mullo_epi64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)), m2);
+    z = _mm256_xor_si256(z, _mm256_srli_epi64(z, 31));
+    if (non_temporal) {
+      _mm256_stream_si256((__m256i *) (dst + i), z);
+    } else {
+      _mm256_storeu_si256((__m256i *) (dst + i), z);
+    }
+    index = _mm256_add_epi64(index, step);
+  }
+}
+
+__attribute__((target("avx512f,avx512dq")))
+void DataGenerator::fill_avx512(uint64_t seed, uint64_t offset, char *dst, size_t len, bool non_temporal) {
+  const __m512i golden = _mm512_set1_epi64((long long) 0x9E3779B97F4A7C15ULL);
+  const __m512i m1 = _mm512_set1_epi64((long long) 0xBF58476D1CE4E5B9ULL);
+  const __m512i m2 = _mm512_set1_epi64((long long) 0x94D049BB133111EBULL);
+  const __m512i vseed = _mm512_set1_epi64((long long) seed);
+  const __m512i step = _mm512_set1_epi64(8);
+  const auto first_index = (long long) (offset/sizeof(uint64_t));
+  __m512i index = _mm512_add_epi64(_mm512_set1_epi64(first_index), _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+
+  for (size_t i = 0; i < len; i += sizeof(__m512i)) {
+    __m512i z = _mm512_xor_si512(vseed, _mm512_mullo_epi64(index, golden));
+    z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 30)), m1);
+    z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 27)), m2);
+    z = _mm512_xor_si512(z, _mm512_srli_epi64(z, 31));
+    if (non_temporal) {
+      _mm512_stream_si512((__m512i *) (dst + i), z);
+    } else {
+      _mm512_storeu_si512((void *) (dst + i), z);
+    }
+    index = _mm512_add_epi64(index, step);
+  }
+}
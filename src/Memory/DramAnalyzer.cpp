@@ -1,17 +1,23 @@
 #include "Memory/DramAnalyzer.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <unordered_set>
 
-DramAnalyzer::DramAnalyzer(BlacksmithConfig &config, volatile char *target) :
-  config(config), start_address(target) {
+#include "Utilities/RunningStats.hpp"
+#include "Utilities/SequentialTest.hpp"
+
+DramAnalyzer::DramAnalyzer(const TranslationContext &ctx) :
+  ctx(ctx), start_address(ctx.get_start_address()) {
   std::random_device rd;
   gen = std::mt19937(rd());
   dist = std::uniform_int_distribution<>(0, std::numeric_limits<int>::max());
 }
 
-size_t DramAnalyzer::analyze_dram(bool check) {
-  DRAMAddr base((void*)start_address);
+size_t DramAnalyzer::analyze_dram(bool check, CalibrationCache *cache, bool reuse_cached) {
+  DRAMAddr base(ctx, (void*)start_address);
   DRAMAddr diff = base.add(0, 1, 0);
   DRAMAddr same = base.add(0, 0, 1);
 
@@ -23,107 +29,193 @@ size_t DramAnalyzer::analyze_dram(bool check) {
     exit(1);
   }
 
-  volatile char* base_virt = (volatile char*)base.to_virt();
-  volatile char* diff_virt = (volatile char*)diff.to_virt();
-  volatile char* same_virt = (volatile char*)same.to_virt();
+  Calibration calibration;
+  if (cache!=nullptr && reuse_cached && cache->lookup(calibration) && (!check || calibration.config_checked)
+      && calibration.bank_thresholds.size()==ctx.get_bank_count() && spot_check(calibration)) {
+    conflict_threshold = calibration.conflict_threshold;
+    bank_thresholds = calibration.bank_thresholds;
+    acts_per_trefi = calibration.acts_per_trefi;
+    refresh_profile = calibration.refresh_profile;
+    Logger::log_info(format_string("Reusing the cached calibration: row conflict threshold %zu, %zu activations per "
+                                   "refresh interval.", conflict_threshold, calibration.acts_per_trefi));
+    log_refresh_profile();
+    return calibration.acts_per_trefi;
+  }
 
-  size_t thresh = determine_conflict_thresh(base_virt, diff_virt, same_virt);
-  if (check) check_addr_function(thresh);
-  return count_acts_per_trefi(base_virt, diff_virt, thresh);
+  determine_conflict_thresholds();
+  calibration.config_checked = check;
+  calibration.config_mismatch_rate = check ? check_addr_function() : 0;
+  calibration.conflict_threshold = conflict_threshold;
+  calibration.bank_thresholds = bank_thresholds;
+  calibration.acts_per_trefi = measure_acts_per_trefi();
+  calibration.refresh_profile = refresh_profile;
+  if (cache!=nullptr) cache->store(calibration);
+  return calibration.acts_per_trefi;
 }
 
-//
-// This method uses some modified code from DetermineConflictThresh.cpp created by Luca Wilke
-//
-size_t DramAnalyzer::determine_conflict_thresh(volatile char *base, volatile char *diff, volatile char *same) {
-  Logger::log_progress("Determining row conflict threshold...");
+size_t DramAnalyzer::measure_acts_per_trefi() {
+  if (bank_thresholds.empty()) determine_conflict_thresholds();
+  DRAMAddr base(ctx, (void*)start_address);
+  DRAMAddr diff = base.add(0, 1, 0);
+  return count_acts_per_trefi((volatile char *) base.to_virt(), (volatile char *) diff.to_virt(),
+                              get_conflict_threshold(base.bank));
+}
+
+bool DramAnalyzer::spot_check(const Calibration &calibration) {
+  std::uniform_int_distribution<size_t> bank_dist(0, calibration.bank_thresholds.size() - 1);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < SPOT_CHECK_PAIRS; ++i) {
+    const size_t bank = bank_dist(gen);
+    const bool conflict = (i%2==0);
+    if ((measure_random_pair(bank, conflict) > calibration.bank_thresholds[bank])!=conflict) mismatches++;
+  }
+  const bool passed = static_cast<double>(mismatches) <= SPOT_CHECK_MAX_MISMATCHES*SPOT_CHECK_PAIRS;
+  if (!passed) {
+    Logger::log_info(format_string("The cached calibration mistimed %zu of %zu address pairs, calibrating again.",
+        mismatches, SPOT_CHECK_PAIRS));
+  }
+  return passed;
+}
 
-  // Measure row conflict timing
-  uint64_t conf_sum = 0;
-  for (size_t sample_idx = 0; sample_idx < THRESH_SAMPLES; sample_idx++) {
-    conf_sum += measure_time(base, diff, 1000);
+uint64_t DramAnalyzer::measure_random_pair(size_t bank, bool conflict) {
+  std::uniform_int_distribution<size_t> page_dist(0, ctx.get_page_count() - 1);
+  std::uniform_int_distribution<size_t> row_dist(0, ctx.get_row_count() - 1);
+  const DRAMAddr a(ctx, bank, row_dist(gen), 0, page_dist(gen));
+  DRAMAddr b = a;
+  if (conflict) {
+    while (b.row==a.row) b.row = row_dist(gen);
+  } else {
+    // any other cache line of the same row, as the second access to the same line would hit in the cache
+    std::uniform_int_distribution<size_t> col_dist(0, ctx.get_mem_config().COL_MASK);
+    while ((size_t) b.to_virt()/CACHELINE_SIZE==(size_t) a.to_virt()/CACHELINE_SIZE) b.col = col_dist(gen);
   }
-  uint64_t conf_avg = conf_sum / THRESH_SAMPLES;
+  return measure_time((volatile char *) a.to_virt(), (volatile char *) b.to_virt(), CALIBRATION_ROUNDS);
+}
 
-  // Measure row hit timing
-  uint64_t hit_sum = 0;
-  for (size_t sample_idx = 0; sample_idx < THRESH_SAMPLES; sample_idx++) {
-    hit_sum += measure_time(base, same, 1000);
+bool DramAnalyzer::calibrate(ThresholdCalibrator &calibrator, size_t first_bank, size_t num_banks,
+                             size_t max_samples) {
+  std::uniform_int_distribution<size_t> bank_dist(first_bank, first_bank + num_banks - 1);
+  while (calibrator.get_num_samples() < max_samples) {
+    for (size_t i = 0; i < CALIBRATION_BATCH; ++i) calibrator.add(measure_random_pair(bank_dist(gen), i%2==0));
+    // stop sampling as soon as hits and conflicts are separated with confidence
+    if (calibrator.get_num_samples() >= CALIBRATION_MIN_SAMPLES && calibrator.is_separated()) return true;
   }
-  uint64_t hit_avg = hit_sum / THRESH_SAMPLES;
+  return false;
+}
 
-  uint64_t thresh = hit_avg + ((conf_avg - hit_avg) / 2);
+void DramAnalyzer::determine_conflict_thresholds() {
+  Logger::log_progress("Determining row conflict threshold...");
+  const size_t bank_count = ctx.get_bank_count();
+
+  ThresholdCalibrator global;
+  const bool separated = calibrate(global, 0, bank_count, CALIBRATION_MAX_SAMPLES);
+  conflict_threshold = global.get_threshold();
   Logger::delete_stdout_line();
-  Logger::log_info(format_string("Determined row conflict threshold to be %lu.", thresh));
-  return thresh;
+  if (!separated) {
+    Logger::log_error(format_string("Row hits and conflicts were not clearly separated after %zu samples, the row "
+                                    "conflict threshold may be inaccurate.", global.get_num_samples()));
+  }
+  Logger::log_info(format_string("Determined row conflict threshold to be %zu (hits: %.0f, conflicts: %.0f, "
+                                 "%zu samples).", conflict_threshold, global.get_fast_mean(), global.get_slow_mean(),
+      global.get_num_samples()));
+
+  // banks on different DIMMs or channels may differ in timing, so calibrate each bank on its own as well
+  Logger::log_progress("Determining per-bank row conflict thresholds...");
+  std::vector<size_t> thresholds(bank_count, conflict_threshold);
+  bool differ = false;
+  for (size_t bank = 0; bank < bank_count; ++bank) {
+    ThresholdCalibrator calibrator;
+    // a bank whose hits and conflicts are not separated after a few samples keeps the global threshold
+    if (!calibrate(calibrator, bank, 1, BANK_CALIBRATION_MAX_SAMPLES)) continue;
+    thresholds[bank] = calibrator.get_threshold();
+    differ |= std::abs(calibrator.get_fast_mean() - global.get_fast_mean())
+        > BANK_TIMING_TOLERANCE*global.get_fast_mean();
+    differ |= std::abs(calibrator.get_slow_mean() - global.get_slow_mean())
+        > BANK_TIMING_TOLERANCE*global.get_slow_mean();
+  }
+  Logger::delete_stdout_line();
+
+  if (differ) {
+    bank_thresholds = thresholds;
+    const auto minmax = std::minmax_element(thresholds.begin(), thresholds.end());
+    Logger::log_info(format_string("The banks differ in timing, using per-bank row conflict thresholds from %zu to "
+                                   "%zu.", *minmax.first, *minmax.second));
+  } else {
+    bank_thresholds.assign(bank_count, conflict_threshold);
+  }
 }
 
-//
-// This method uses some modified code from CheckAddrFunction.cpp created by Luca Wilke
-//
-void DramAnalyzer::check_addr_function(size_t thresh) {
+double DramAnalyzer::check_addr_function() {
   Logger::log_progress("Checking correctness of config file...");
 
-  size_t bank_count = DRAMAddr::get_bank_count();
-  size_t row_count = DRAMAddr::get_row_count();
-  size_t checked_banks = 4;
-  if (bank_count < checked_banks)
-    checked_banks = bank_count;
+  const size_t bank_count = ctx.get_bank_count();
+  std::uniform_int_distribution<size_t> page_dist(0, ctx.get_page_count() - 1);
+  std::uniform_int_distribution<size_t> bank_dist(0, bank_count - 1);
+  std::uniform_int_distribution<size_t> row_dist(0, ctx.get_row_count() - 1);
 
-  for(size_t bank = 0; bank < checked_banks; bank++) {
-  Logger::delete_stdout_line();
-  Logger::log_progress(format_string("Checking correctness of config file (bank %zu)...", bank));
-    for(size_t row = 1; row < row_count; row++) {
-      auto addrA = DRAMAddr(bank,0,0);
-      auto addrB = DRAMAddr(bank,row,0);
-      auto timing = DramAnalyzer::measure_time((volatile char*)addrA.to_virt(),(volatile char*)addrB.to_virt(), 1000);
-      if(timing < thresh) {
-        Logger::log_error(format_string("Measured access time of %lu for two supposedly conflicting rows, "
-                                        "which is below the row conflict threshold of %lu.",
-                                        timing, thresh));
-        Logger::log_error("The chosen config file may not be compatible with your system.");
-        exit(1);
-      }
+  SequentialTest test(CHECK_CORRECT_RATE, CHECK_WRONG_RATE, CHECK_ERROR_PROB, CHECK_ERROR_PROB);
+  const size_t min_pairs = std::min(CHECK_MIN_PAIRS_PER_BANK*bank_count, CHECK_MAX_PAIRS);
+  while (test.get_num_samples() < CHECK_MAX_PAIRS
+      && (test.get_num_samples() < min_pairs || test.get_decision()==SequentialTest::Decision::UNDECIDED)) {
+    // alternate between pairs that must conflict (same bank, different rows), which catches wrong row functions and
+    // banks that are split, and pairs that must not (different banks), which catches banks that are merged
+    const bool same_bank = (test.get_num_samples()%2==0) || bank_count==1;
+    const DRAMAddr a(ctx, bank_dist(gen), row_dist(gen), 0, page_dist(gen));
+    DRAMAddr b = a;
+    if (same_bank) {
+      while (b.row==a.row) b.row = row_dist(gen);
+    } else {
+      while (b.bank==a.bank) b.bank = bank_dist(gen);
+      b.row = row_dist(gen);
     }
+    const auto timing = measure_time((volatile char *) a.to_virt(), (volatile char *) b.to_virt(), 1000);
+    test.add((timing > get_conflict_threshold(a.bank))!=same_bank);
   }
 
+  // if the test did not decide within CHECK_MAX_PAIRS pairs, the observed rate is closer to one of the two
+  bool correct = test.get_decision()==SequentialTest::Decision::LOW_RATE;
+  if (test.get_decision()==SequentialTest::Decision::UNDECIDED)
+    correct = test.get_rate() < (CHECK_CORRECT_RATE + CHECK_WRONG_RATE)/2;
+
   Logger::delete_stdout_line();
-  Logger::log_info("Selected config file has been checked, and seems to be correct.");
+  if (!correct) {
+    Logger::log_error(format_string("%zu of %zu random address pairs (%.1f%%) were timed differently than the config "
+                                    "predicts for the row conflict threshold of %zu.",
+        test.get_num_events(), test.get_num_samples(), 100*test.get_rate(), conflict_threshold));
+    Logger::log_error("The chosen config file may not be compatible with your system.");
+    exit(1);
+  }
+  Logger::log_info(format_string("Selected config file has been checked with %zu random address pairs (%.1f%% "
+                                 "mismatches), and seems to be correct.", test.get_num_samples(),
+      100*test.get_rate()));
+  return test.get_rate();
 }
 
 size_t DramAnalyzer::count_acts_per_trefi(volatile char *base, volatile char *diff, size_t start_threshold) {
   Logger::log_progress("Determining number of activations per refresh interval...");
-  uint64_t acts_per_ref;
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + std::chrono::milliseconds(ACTS_TIME_BUDGET_MS);
+  const uint64_t start_tsc = rdtscp();
+  refresh_profiler.clear();
 
-  size_t skip_first_N = 50;
-  std::vector<uint64_t> acts;
-  uint64_t running_sum = 0;
-  uint64_t before;
-  uint64_t after;
+  RunningStats stats;
+  size_t threshold = start_threshold;
+  size_t threshold_steps = 0;
   uint64_t count = 0;
+  // the value of count at the last access delayed by a refresh (0 = none yet)
   uint64_t count_old = 0;
-  size_t threshold = start_threshold;
+  bool converged = false;
 
-  // computes the standard deviation
-  auto compute_std = [](std::vector<uint64_t> &values, uint64_t running_sum, size_t num_numbers) {
-    double mean = static_cast<double>(running_sum)/static_cast<double>(num_numbers);
-    double var = 0;
-    for (const auto &num : values) {
-      if (static_cast<double>(num) < mean) continue;
-      var += std::pow(static_cast<double>(num) - mean, 2);
-    }
-    auto val = std::sqrt(var/static_cast<double>(num_numbers));
-    return val;
-  };
+  for (uint64_t i = 0;; i++) {
+    if (i%ACTS_CLOCK_CHECK_INTERVAL==0 && std::chrono::steady_clock::now() >= deadline) break;
 
-  for (size_t i = 0;; i++) {
     // flush base and diff from caches
     clflushopt(base);
     clflushopt(diff);
     mfence();
 
     // get start timestamp and wait until we retrieved it
-    before = rdtscp();
+    const uint64_t before = rdtscp();
     lfence();
 
     // do DRAM accesses
@@ -131,43 +223,72 @@ size_t DramAnalyzer::count_acts_per_trefi(volatile char *base, volatile char *di
     (void)*diff;
 
     // get end timestamp
-    after = rdtscp();
+    const uint64_t after = rdtscp();
 
     count++;
-    if ((after - before) > threshold) {
-      if (i > skip_first_N && count_old!=0) {
-        // multiply by 2 to account for both accesses we do (base, diff)
-        uint64_t value = (count - count_old)*2;
-        acts.push_back(value);
-        running_sum += value;
-        // check the collected values after every 200 rounds
-        if ((acts.size()%200)==0)
-        {
-          acts_per_ref = running_sum / acts.size();
-          // restart with a higher threshold if acts_per_ref falls too low or std still hasn't converged after 10 checks
-          if (acts_per_ref <= 5 || acts.size() > 2000) {
-            acts.clear();
-            running_sum = 0;
-            i = 0;
-            if (threshold < start_threshold + 200) {
-              if (threshold == start_threshold)
-                Logger::log_debug("Increasing threshold");
-              threshold += 10;
-            } else {
-              threshold = start_threshold;
-              Logger::log_debug(format_string("Threshold too high, resetting to %zu", start_threshold));
-            }
-          // a standard deviation of less than 3 means the average will probably be accurate, so we go ahead with these measurements
-          } else if (compute_std(acts, running_sum, acts.size()) < 3.0) {
-            Logger::delete_stdout_line();
-            Logger::log_info(format_string("Determined number of row activations per refresh interval to be %lu.", acts_per_ref));
-            break;
-          }
-        }
-      }
-      count_old = count;
+    if ((after - before) <= threshold) continue;
+
+    // the accesses since the previous delayed one fit into one refresh interval; the first interval is incomplete
+    if (count > ACTS_SKIP_ACCESSES) {
+      refresh_profiler.record(before);
+      // multiply by 2 to account for both accesses we do (base, diff)
+      if (count_old!=0) stats.add(static_cast<double>((count - count_old)*2));
+    }
+    count_old = count;
+    if (stats.get_count() < ACTS_MIN_INTERVALS) continue;
+
+    if (stats.get_mean() <= ACTS_MIN_PLAUSIBLE) {
+      // most accesses exceed the threshold, so it does not single out the refreshes: start over with a higher one
+      if (threshold_steps==ACTS_MAX_THRESHOLD_STEPS) break;
+      threshold_steps++;
+      threshold += ACTS_THRESHOLD_STEP;
+      Logger::log_debug(format_string("Increasing threshold to %zu", threshold));
+      stats.clear();
+      refresh_profiler.clear();
+      count = count_old = 0;
+    } else if (stats.get_ci_half_width() <= ACTS_MAX_RELATIVE_CI*stats.get_mean()) {
+      converged = true;
+      break;
     }
   }
 
-  return acts_per_ref;
+  const auto end = std::chrono::steady_clock::now();
+  const uint64_t end_tsc = rdtscp();
+  const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+  // the TSC frequency, calibrated against the steady clock over the whole measurement
+  const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  refresh_profile = refresh_profiler.analyze(static_cast<double>(end_tsc - start_tsc)/static_cast<double>(elapsed_ns));
+
+  const bool plausible = stats.get_count() >= ACTS_MIN_INTERVALS && stats.get_mean() > ACTS_MIN_PLAUSIBLE;
+  Logger::delete_stdout_line();
+  if (plausible) {
+    acts_per_trefi = static_cast<size_t>(std::llround(stats.get_mean()));
+    const auto msg = format_string("row activations per refresh interval to be %zu (95%% CI: +/- %.1f, %zu refresh "
+                                   "intervals, %ld ms)", acts_per_trefi, stats.get_ci_half_width(), stats.get_count(),
+        elapsed_ms);
+    if (converged) {
+      Logger::log_info("Determined number of " + msg + ".");
+    } else {
+      Logger::log_error("Estimated number of " + msg + ", which did not converge within the time budget.");
+    }
+  } else {
+    if (acts_per_trefi==0) acts_per_trefi = ACTS_PER_TREFI_FALLBACK;
+    Logger::log_error(format_string("Could not tell refreshes apart within %ld ms, falling back to %zu row activations "
+                                    "per refresh interval.", elapsed_ms, acts_per_trefi));
+  }
+  log_refresh_profile();
+  return acts_per_trefi;
+}
+
+void DramAnalyzer::log_refresh_profile() const {
+  if (!refresh_profile.is_valid()) {
+    Logger::log_error(format_string("Could not determine the refresh interval from %zu delayed accesses, assuming "
+                                    "%.1f us.", refresh_profile.num_delays, RefreshProfiler::NOMINAL_TREFI_NS/1000));
+    return;
+  }
+  Logger::log_info(format_string("Refreshes arrive every %.0f ns%s with a jitter of %.0f ns (%.0f%% of %zu delayed "
+                                 "accesses on schedule, TSC at %.2f GHz).", refresh_profile.trefi_ns,
+      refresh_profile.double_refresh ? " (2x refresh)" : "", refresh_profile.jitter_ns,
+      100*refresh_profile.phase_stability, refresh_profile.num_delays, refresh_profile.tsc_ghz));
+  Logger::log_data("Intervals between delayed accesses: " + refresh_profile.get_histogram_text());
 }
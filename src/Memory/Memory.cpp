@@ -1,99 +1,453 @@
 #include "Memory/Memory.hpp"
 
+#include <algorithm>
 #include <sys/mman.h>
+#include <thread>
 
-/// Allocates a MEM_SIZE bytes of memory by using super or huge pages.
+#include "Memory/DramGeometry.hpp"
+#include "Memory/RowDigest.hpp"
+#include "Memory/VictimVerifier.hpp"
+#include "Utilities/CpuTopology.hpp"
+#include "Utilities/TimeHelper.hpp"
+
+/// Takes over the pool of superpages (HUGEPAGE_SIZE bytes each) described by the translation context, which was mapped
+/// by map_superpages before the context was created.
 void Memory::allocate_memory() {
-  this->size = MEM_SIZE;
+  const size_t num_pages = ctx.get_page_count();
+  this->size = num_pages*HUGEPAGE_SIZE;
+  Logger::log_info(format_string("Allocated a pool of %zu superpage(s) at %p.", num_pages, start_address));
+  ledger.resize(ctx);
+
+  // initialize memory with random but reproducible sequence of numbers
+  if (lazy_init) {
+    Logger::log_info("Lazy initialization enabled, rows are initialized when a mapping uses them for the first time.");
+  } else {
+    initialize(DATA_PATTERN::RANDOM);
+  }
+  Logger::log_info(format_string("Using %s kernel for victim verification.", VictimVerifier::get_kernel_name()));
+  Logger::log_info(format_string("Using %s kernel for row digests.", RowDigest::get_kernel_name()));
+  Logger::log_info(format_string("Using %s kernel for batched address translation.",
+      ctx.get_batch_kernel_name()));
+}
+
+volatile char *Memory::map_superpages(volatile char *start_address, size_t num_pages, bool superpage) {
+  const size_t size = num_pages*HUGEPAGE_SIZE;
   volatile char *target = nullptr;
   FILE *fp;
 
   if (superpage) {
     // allocate memory using super pages
-    fp = fopen(hugetlbfs_mountpoint.c_str(), "w+");
+    fp = fopen(hugetlbfs_mountpoint, "w+");
     if (fp==nullptr) {
-      Logger::log_info(format_string("Could not mount superpage from %s. Error:", hugetlbfs_mountpoint.c_str()));
+      Logger::log_info(format_string("Could not mount superpage from %s. Error:", hugetlbfs_mountpoint));
       Logger::log_data(std::strerror(errno));
       exit(EXIT_FAILURE);
     }
-    auto mapped_target = mmap((void *) start_address, MEM_SIZE, PROT_READ | PROT_WRITE,
+    // a single mapping makes the superpages of the pool virtually contiguous, which DRAMAddr relies on
+    auto mapped_target = mmap((void *) start_address, size, PROT_READ | PROT_WRITE,
         MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB | (30UL << MAP_HUGE_SHIFT), fileno(fp), 0);
     if (mapped_target==MAP_FAILED) {
       perror("mmap");
+      Logger::log_error(format_string("Could not map %zu superpage(s) of 1 GB. Are enough hugepages reserved?",
+          num_pages));
       exit(EXIT_FAILURE);
     }
     target = (volatile char*) mapped_target;
   } else {
-    // allocate memory using huge pages
-    assert(posix_memalign((void **) &target, MEM_SIZE, MEM_SIZE)==0);
-    assert(madvise((void *) target, MEM_SIZE, MADV_HUGEPAGE)==0);
-    memset((char *) target, 'A', MEM_SIZE);
+    // allocate memory using huge pages; superpages of 1 GB are aligned by the kernel, here we have to align the pool
+    // ourselves, so one superpage more is mapped and the unaligned head and the remaining tail are unmapped again
+    auto mapped_target = mmap((void *) start_address, size + HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped_target==MAP_FAILED) {
+      perror("mmap");
+      Logger::log_error(format_string("Could not map %zu huge page-backed superpage(s).", num_pages));
+      exit(EXIT_FAILURE);
+    }
+    const auto mapped = (uintptr_t) mapped_target;
+    const uintptr_t aligned = (mapped + HUGEPAGE_SIZE - 1) & ~((uintptr_t) HUGEPAGE_SIZE - 1);
+    if (aligned > mapped) munmap(mapped_target, aligned - mapped);
+    munmap((void *) (aligned + size), mapped + HUGEPAGE_SIZE - aligned);
+    target = (volatile char*) aligned;
+    assert(madvise((void *) target, size, MADV_HUGEPAGE)==0);
+    memset((char *) target, 'A', size);
     // for khugepaged
     Logger::log_info("Waiting for khugepaged.");
     sleep(10);
   }
 
+  // the caller creates the translation context from the address the pool actually got
   if (target!=start_address) {
     Logger::log_error(format_string("Could not create mmap area at address %p, instead using %p.",
         start_address, target));
-    start_address = target;
   }
-
-  // initialize memory with random but reproducible sequence of numbers
-  initialize(DATA_PATTERN::RANDOM);
+  return target;
 }
 
 void Memory::initialize(DATA_PATTERN data_pattern) {
   Logger::log_progress("Initializing memory...");
+  const auto start_ts = get_timestamp_us();
+
+  if (data_pattern != DATA_PATTERN::RANDOM && data_pattern != DATA_PATTERN::ZEROES
+      && data_pattern != DATA_PATTERN::ONES) {
+    Logger::log_error("Could not initialize memory with given DATA_PATTERN, only ZEROES, ONES, and RANDOM are "
+                      "supported for the whole memory.");
+    return;
+  }
+
+  // run the workers on the NUMA node that owns the memory so that no store has to cross the interconnect
+  const int node = CpuTopology::get_numa_node(start_address);
+  const auto cpus = CpuTopology::get_node_cpus(node);
+  const size_t num_threads = std::max(cpus.size(), (size_t) 1);
+
+  // split the region into contiguous, page-aligned chunks of (almost) equal size
+  const auto pagesize = static_cast<uint64_t>(getpagesize());
+  const uint64_t num_pages = size/pagesize;
+  const uint64_t pages_per_thread = (num_pages + num_threads - 1)/num_threads;
+
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < num_threads; ++t) {
+    const uint64_t first = std::min(num_pages, t*pages_per_thread)*pagesize;
+    const uint64_t last = std::min(num_pages, (t + 1)*pages_per_thread)*pagesize;
+    const int cpu = cpus.empty() ? -1 : cpus[t];
+    // each worker pins itself before its first store, which would otherwise be done on whatever CPU it started on
+    workers.emplace_back([this, data_pattern, first, last, cpu]() {
+      if (cpu!=-1 && !CpuTopology::pin_thread(pthread_self(), cpu))
+        Logger::log_debug(format_string("Could not pin initialization thread to CPU %d.", cpu));
+      initialize_range(data_pattern, first, last);
+    });
+  }
+  for (auto &worker : workers) worker.join();
+  if (data_pattern==DATA_PATTERN::RANDOM) ledger.mark_all_initialized();
+
+  Logger::delete_stdout_line();
+  if (data_pattern==DATA_PATTERN::RANDOM) {
+    Logger::log_info(format_string("Memory initialized with pseudorandom sequence (seed: 0x%lx).", generator.seed));
+  } else {
+    Logger::log_info(format_string("Memory initialized with data pattern %s.", to_string(data_pattern).c_str()));
+  }
+  Logger::log_data(format_string("Initialization took %ld ms using %zu threads on NUMA node %d.",
+      (get_timestamp_us() - start_ts)/1000, num_threads, node));
+
+  if (data_pattern==DATA_PATTERN::RANDOM) build_row_digests();
+}
+
+void Memory::build_row_digests() {
+  const auto start_ts = get_timestamp_us();
+  const auto cpus = CpuTopology::get_node_cpus(CpuTopology::get_numa_node(start_address));
+  const size_t num_threads = std::max(cpus.size(), (size_t) 1);
+  const size_t num_rows = ledger.size();
+  const size_t rows_per_thread = (num_rows + num_threads - 1)/num_threads;
+
+  // each worker writes the digests of a disjoint range of rows, so no synchronization is needed
+  auto worker_fn = [this](size_t first, size_t last, int cpu) {
+    if (cpu!=-1 && !CpuTopology::pin_thread(pthread_self(), cpu))
+      Logger::log_debug(format_string("Could not pin digest thread to CPU %d.", cpu));
+    for (size_t idx = first; idx < last; ++idx) {
+      const auto row = ledger.row_at(idx);
+      ledger.set_digest(row, get_row_digest(RowLines(row), true));
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back(worker_fn, std::min(num_rows, t*rows_per_thread), std::min(num_rows, (t + 1)*rows_per_thread),
+                         cpus.empty() ? -1 : cpus[t]);
+  }
+  for (auto &worker : workers) worker.join();
+
+  Logger::log_info(format_string("Computed the digests of %zu rows in %ld ms using the %s CRC32C kernel.",
+      num_rows, (get_timestamp_us() - start_ts)/1000, RowDigest::get_kernel_name()));
+}
+
+uint32_t Memory::get_row_digest(const RowLines &lines, bool expected) const {
+  alignas(CACHELINE_SIZE) char expected_line[CACHELINE_SIZE];
+  uint32_t digest = 0;
+  for (const auto &line : lines) {
+    if (expected) {
+      generator.fill((uint64_t) (line - start_address), expected_line, CACHELINE_SIZE);
+      digest = RowDigest::crc32c(digest, expected_line, CACHELINE_SIZE);
+    } else {
+      digest = RowDigest::crc32c(digest, line, CACHELINE_SIZE);
+    }
+  }
+  return digest;
+}
+
+void Memory::initialize_range(DATA_PATTERN data_pattern, uint64_t start_offset, uint64_t end_offset) {
+  const auto pagesize = static_cast<uint64_t>(getpagesize());
 
   // for each page in the address space [start, end]
-  for (uint64_t cur_page = 0; cur_page < size; cur_page += getpagesize()) {
-    // reseed rand to have a sequence of reproducible numbers, using this we can compare the initialized values with
-    // those after hammering to see whether bit flips occurred
-    srand(static_cast<unsigned int>(cur_page*getpagesize()));
-    for (uint64_t cur_pageoffset = 0; cur_pageoffset < (uint64_t) getpagesize(); cur_pageoffset += sizeof(int)) {
-
-      int fill_value = 0;
-      if (data_pattern == DATA_PATTERN::RANDOM) {
-        fill_value = rand();
-      } else if (data_pattern == DATA_PATTERN::ZEROES) {
-        fill_value = 0;
-      } else if (data_pattern == DATA_PATTERN::ONES) {
-        fill_value = 1;
-      } else {
-        Logger::log_error("Could not initialize memory with given (unknown) DATA_PATTERN.");
+  for (uint64_t cur_page = start_offset; cur_page < end_offset; cur_page += pagesize) {
+    auto page = (char *) (start_address + cur_page);
+
+    if (data_pattern == DATA_PATTERN::RANDOM) {
+      // the values only depend on the seed and the offset, using this we can compare the initialized values with
+      // those after hammering to see whether bit flips occurred; streaming stores keep this data out of the LLC
+      // so that it does not distort the timing measurements done afterwards
+      generator.fill(cur_page, page, pagesize, true);
+    } else if (data_pattern == DATA_PATTERN::ZEROES) {
+      memset(page, 0, pagesize);
+    } else if (data_pattern == DATA_PATTERN::ONES) {
+      for (uint64_t cur_pageoffset = 0; cur_pageoffset < pagesize; cur_pageoffset += sizeof(int))
+        *((int *) (page + cur_pageoffset)) = 1;
+    }
+  }
+}
+
+void Memory::initialize_rows(PatternAddressMapper &mapping) {
+  if (!lazy_init) return;
+  const auto start_ts = get_timestamp_us();
+
+  std::vector<DRAMAddr> rows;
+  std::vector<DRAMAddr> victims;
+  get_mapping_rows(mapping, rows, victims);
+  rows.insert(rows.end(), victims.begin(), victims.end());
+
+  size_t initialized_rows = 0;
+  for (const auto &row : rows) {
+    // a row the ledger does not track (e.g., an aggressor shifted beyond the last row) would be rewritten every time
+    if (!ledger.contains(row) || ledger.is_initialized(row)) continue;
+    restore_row(row);
+    initialized_rows++;
+  }
+  Logger::log_debug(format_string("Lazily initialized %zu row(s) in %ld us.",
+      initialized_rows, get_timestamp_us() - start_ts));
+}
+
+void Memory::prepare_probe(PatternAddressMapper &mapping) {
+  initialize_rows(mapping);
+
+  // rows hammered by an earlier probe that were never checked may still contain bit flips: restore them now so that
+  // these flips are not reported for this probe (and do not linger in memory); as every such row is restored here, a
+  // flip found by the following check is always caused by this probe
+  auto dirty_rows = ledger.take_dirty_rows();
+  for (const auto &row : dirty_rows) {
+    restore_row(row);
+  }
+  if (!dirty_rows.empty())
+    Logger::log_info(format_string("Restored %zu row(s) that were hammered but never verified.", dirty_rows.size()));
+
+  for (const auto &victim_row : mapping.get_victim_rows()) {
+    ledger.mark_hammered(victim_row);
+  }
+
+  apply_data_pattern(mapping);
+}
+
+void Memory::get_mapping_rows(PatternAddressMapper &mapping, std::vector<DRAMAddr> &aggressors,
+                              std::vector<DRAMAddr> &victims) {
+  for (auto &agg_addr : mapping.aggressor_to_addr) {
+    aggressors.emplace_back(ctx, (void *) agg_addr.second.to_virt());
+  }
+  const auto &victim_rows = mapping.get_victim_rows();
+  victims.insert(victims.end(), victim_rows.begin(), victim_rows.end());
+}
+
+uint8_t Memory::get_pattern_byte(DATA_PATTERN data_pattern, const DRAMAddr &row) const {
+  switch (data_pattern) {
+    case DATA_PATTERN::ZEROES:
+      return 0x00;
+    case DATA_PATTERN::ONES:
+      return 0xFF;
+    case DATA_PATTERN::ROW_STRIPE:
+      return (row.row%2==0) ? 0xFF : 0x00;
+    case DATA_PATTERN::CHECKERBOARD:
+      return (row.row%2==0) ? 0x55 : 0xAA;
+    case DATA_PATTERN::COLUMN_STRIPE:
+      return 0x55;
+    case DATA_PATTERN::AGGRESSOR_INVERSE:
+      for (const auto &agg : pattern_aggressors) {
+        if (agg.page==row.page && agg.bank==row.bank && agg.row==row.row) return 0xFF;
       }
-        
-      // write (pseudo)random 4 bytes
-      uint64_t offset = cur_page + cur_pageoffset;
-      *((int *) (start_address + offset)) = fill_value;
+      return 0x00;
+    default:
+      Logger::log_error(format_string("Data pattern %s has no fixed row contents.", to_string(data_pattern).c_str()));
+      exit(EXIT_FAILURE);
+  }
+}
+
+void Memory::fill_expected(DATA_PATTERN data_pattern, uint64_t offset, char *dst, size_t len) const {
+  if (data_pattern==DATA_PATTERN::RANDOM) {
+    generator.fill(offset, dst, len);
+    return;
+  }
+  // adjacent cache lines may belong to different rows (or even banks), so the value is determined for each line
+  for (size_t l = 0; l < len; l += CACHELINE_SIZE) {
+    const DRAMAddr row(ctx, (void *) (start_address + offset + l));
+    memset(dst + l, get_pattern_byte(data_pattern, row), CACHELINE_SIZE);
+  }
+}
+
+void Memory::apply_data_pattern(PatternAddressMapper &mapping) {
+  pattern_aggressors.clear();
+  if (mapping.data_pattern==DATA_PATTERN::RANDOM) return;
+
+  std::vector<DRAMAddr> rows;
+  get_mapping_rows(mapping, pattern_aggressors, rows);
+  rows.insert(rows.end(), pattern_aggressors.begin(), pattern_aggressors.end());
+
+  for (const auto &row : rows) {
+    for (const auto &line : RowLines(row)) {
+      memset((void *) line, get_pattern_byte(mapping.data_pattern, row), CACHELINE_SIZE);
+      clflushopt(line);
     }
   }
-  
-  Logger::delete_stdout_line();
-  Logger::log_info("Memory initialized with pseudorandom sequence.");
+  mfence();
+  Logger::log_debug(format_string("Wrote data pattern %s to %zu row(s).",
+      to_string(mapping.data_pattern).c_str(), rows.size()));
+}
+
+void Memory::restore_row(const DRAMAddr &row) {
+  alignas(CACHELINE_SIZE) char expected_line[CACHELINE_SIZE];
+  uint32_t digest = 0;
+  for (const auto &line : RowLines(row)) {
+    generator.fill((uint64_t) (line - start_address), expected_line, CACHELINE_SIZE);
+    digest = RowDigest::crc32c(digest, expected_line, CACHELINE_SIZE);
+    memcpy((void *) line, expected_line, CACHELINE_SIZE);
+    clflushopt(line);
+  }
+  mfence();
+  ledger.mark_initialized(row);
+  ledger.set_digest(row, digest);
 }
 
 size_t Memory::check_memory(PatternAddressMapper &mapping, bool reproducibility_mode, bool verbose) {
   flipped_bits.clear();
 
-  auto victim_rows = mapping.get_victim_rows();
+  const auto &victim_rows = mapping.get_victim_rows();
   if (verbose) Logger::log_info(format_string("Checking %zu victims for bit flips.", victim_rows.size()));
 
-  size_t sum_found_bitflips = 0;
+  const auto start_ts = get_timestamp_us();
+
+  // collect exactly the cache lines that belong to the victim rows, sorted so that neighboring lines can be checked
+  // together and so that lines shared by overlapping victims are only checked once; rows whose digest matches the
+  // digest of their expected contents have no bit flips and do not need to be compared line by line
+  std::vector<volatile char *> lines;
+  size_t digest_verified_rows = 0;
+  for (const auto &row : victim_rows) {
+    const RowLines row_lines(row);
+    uint32_t expected_digest;
+    if (mapping.data_pattern==DATA_PATTERN::RANDOM && ledger.get_digest(row, expected_digest)
+        && get_row_digest(row_lines, false)==expected_digest) {
+      digest_verified_rows++;
+      continue;
+    }
+    lines.insert(lines.end(), row_lines.begin(), row_lines.end());
+  }
+  std::sort(lines.begin(), lines.end());
+  lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+  std::vector<DRAMAddr> pattern_rows;
+  if (mapping.data_pattern!=DATA_PATTERN::RANDOM) {
+    pattern_aggressors.clear();
+    get_mapping_rows(mapping, pattern_aggressors, pattern_rows);
+    pattern_rows.insert(pattern_rows.end(), pattern_aggressors.begin(), pattern_aggressors.end());
+  }
+
+  size_t sum_found_bitflips = check_lines(mapping, lines, reproducibility_mode, verbose);
   for (const auto &victim_row : victim_rows) {
-    auto victim_dram_addr = DRAMAddr((char*)victim_row);
-    victim_dram_addr.add_inplace(0, 1, 0);
-    sum_found_bitflips += check_memory_internal(mapping, victim_row,
-        (volatile char *) victim_dram_addr.to_virt(), reproducibility_mode, verbose);
+    ledger.mark_verified(victim_row);
+  }
+
+  // the rest of the memory (and the scrubber) expects the random data, so the pattern's rows are restored
+  for (const auto &row : pattern_rows) {
+    restore_row(row);
   }
+
+  if (!flipped_bits.empty()) {
+    size_t z2o = 0, o2z = 0;
+    for (const auto &bitflip : flipped_bits) {
+      z2o += bitflip.count_z2o_corruptions();
+      o2z += bitflip.count_o2z_corruptions();
+    }
+    Logger::log_info(format_string("Bit flips with data pattern %s: %zu 0->1, %zu 1->0.",
+        to_string(mapping.data_pattern).c_str(), z2o, o2z));
+  }
+
+  const size_t checked_bytes = lines.size()*CACHELINE_SIZE
+      + digest_verified_rows*ctx.get_lines_per_row()*CACHELINE_SIZE;
+  const auto elapsed_us = std::max(get_timestamp_us() - start_ts, (int64_t) 1);
+  Logger::log_debug(format_string("Verified %zu bytes in %ld us (%.2f GB/s), %zu of %zu row(s) by digest only.",
+      checked_bytes, elapsed_us, static_cast<double>(checked_bytes)/static_cast<double>(elapsed_us)/1e3,
+      digest_verified_rows, victim_rows.size()));
   return sum_found_bitflips;
 }
 
+size_t Memory::check_lines(PatternAddressMapper &mapping, const std::vector<volatile char *> &lines,
+                           bool reproducibility_mode, bool verbose) {
+  size_t found_bitflips = 0;
+
+  // the expected contents of up to 64 consecutive cache lines
+  alignas(CACHELINE_SIZE) char expected[64*CACHELINE_SIZE];
+
+  for (size_t i = 0; i < lines.size();) {
+    // coalesce a run of up to 64 adjacent cache lines, so they can be generated and compared in one go
+    size_t run = 1;
+    while (run < 64 && i + run < lines.size() && lines[i + run]==lines[i] + run*CACHELINE_SIZE) run++;
+
+    auto offset = (uint64_t) (lines[i] - start_address);
+    if (offset + run*CACHELINE_SIZE > size) {
+      Logger::log_error(format_string("Skipping check of cache line %p outside of the allocated memory.", lines[i]));
+      i += run;
+      continue;
+    }
+
+    fill_expected(mapping.data_pattern, offset, expected, run*CACHELINE_SIZE);
+    uint64_t mismatches = VictimVerifier::compare_lines(lines[i], expected, run);
+    while (mismatches!=0) {
+      const auto line = static_cast<size_t>(__builtin_ctzll(mismatches));
+      mismatches &= (mismatches - 1);
+      found_bitflips += extract_bitflips(mapping, lines[i] + line*CACHELINE_SIZE, expected + line*CACHELINE_SIZE,
+          reproducibility_mode, verbose);
+    }
+    i += run;
+  }
+
+  return found_bitflips;
+}
+
+size_t Memory::scrub_row(const DRAMAddr &row, std::vector<BitFlip> &flips) {
+  size_t found_bitflips = 0;
+  // the contents of a row that was never initialized are arbitrary
+  if (!ledger.is_initialized(row)) return found_bitflips;
+
+  const RowLines lines(row);
+
+  uint32_t expected_digest;
+  if (ledger.get_digest(row, expected_digest) && get_row_digest(lines, false)==expected_digest)
+    return found_bitflips;
+
+  alignas(CACHELINE_SIZE) char expected[CACHELINE_SIZE];
+  for (const auto &line : lines) {
+    auto offset = (uint64_t) (line - start_address);
+    if (offset + CACHELINE_SIZE > size) continue;
+
+    generator.fill(offset, expected, CACHELINE_SIZE);
+    if (VictimVerifier::compare_lines(line, expected, 1)==0) continue;
+
+    // make sure that we do not look at a stale cached copy
+    clflushopt(line);
+    mfence();
+    for (size_t b = 0; b < CACHELINE_SIZE; ++b) {
+      const auto actual_value = (uint8_t) line[b];
+      const auto expected_value = (uint8_t) expected[b];
+      if (actual_value==expected_value) continue;
+      BitFlip bitflip(DRAMAddr(ctx, (void *) (line + b)), (uint8_t) (expected_value ^ actual_value), actual_value);
+      found_bitflips += bitflip.count_bit_corruptions();
+      flips.push_back(bitflip);
+      line[b] = (char) expected_value;
+    }
+    clflushopt(line);
+  }
+  mfence();
+
+  return found_bitflips;
+}
+
 size_t Memory::check_memory(const volatile char *start, const volatile char *end) {
   flipped_bits.clear();
   // create a "fake" pattern mapping to keep this method for backward compatibility
-  PatternAddressMapper pattern_mapping(config.total_banks);
+  PatternAddressMapper pattern_mapping(ctx);
   return check_memory_internal(pattern_mapping, start, end, false, true);
 }
 
@@ -107,8 +461,8 @@ size_t Memory::check_memory_internal(PatternAddressMapper &mapping,
 
   if (start==nullptr || end==nullptr || ((uint64_t) start >= (uint64_t) end)) {
     Logger::log_error("Function check_memory called with invalid arguments.");
-    Logger::log_data(format_string("Start addr.: %s", DRAMAddr((void *) start).to_string().c_str()));
-    Logger::log_data(format_string("End addr.: %s", DRAMAddr((void *) end).to_string().c_str()));
+    Logger::log_data(format_string("Start addr.: %s", DRAMAddr(ctx, (void *) start).to_string().c_str()));
+    Logger::log_data(format_string("End addr.: %s", DRAMAddr(ctx, (void *) end).to_string().c_str()));
     return found_bitflips;
   }
 
@@ -120,91 +474,111 @@ size_t Memory::check_memory_internal(PatternAddressMapper &mapping,
   auto end_offset = start_offset + (uint64_t) (end - start);
   end_offset = (end_offset/pagesize)*pagesize;
 
-  void *page_raw = malloc(pagesize);
-  if (page_raw == nullptr) {
+  // the expected page contents; aligned so that the comparison kernel can use aligned vector loads
+  char *page = (char *) aligned_alloc(CACHELINE_SIZE, pagesize);
+  if (page == nullptr) {
     Logger::log_error("Could not create temporary page for memory comparison.");
     exit(EXIT_FAILURE);
   }
-  memset(page_raw, 0, pagesize);
-  int *page = (int*)page_raw;
+  const size_t lines_per_page = pagesize/CACHELINE_SIZE;
 
   // for each page (4K) in the address space [start, end]
   for (uint64_t i = start_offset; i < end_offset; i += pagesize) {
-    // reseed rand to have the desired sequence of reproducible numbers
-    srand(static_cast<unsigned int>(i*pagesize));
+    uint64_t addr = ((uint64_t)start_address+i);
+
+    // if this page is outside the allocated area we must not proceed to avoid segfault
+    if ((addr+pagesize) > ((uint64_t)start_address+size))
+      break;
+
+    // fill comparison page with the values expected at this offset
+    generator.fill(i, page, pagesize);
+
+    // compare the whole page in wide registers, only cache lines that differ need to be inspected byte-by-byte
+    for (size_t first_line = 0; first_line < lines_per_page; first_line += 64) {
+      const size_t num_lines = std::min(lines_per_page - first_line, (size_t) 64);
+      uint64_t mismatches = VictimVerifier::compare_lines((volatile char *) addr + first_line*CACHELINE_SIZE,
+          page + first_line*CACHELINE_SIZE, num_lines);
+
+      while (mismatches!=0) {
+        const auto line = first_line + static_cast<size_t>(__builtin_ctzll(mismatches));
+        mismatches &= (mismatches - 1);
+        if (lazy_init && !ledger.is_initialized(DRAMAddr(ctx, (void *) (start_address + i + line*CACHELINE_SIZE))))
+          continue;
+        found_bitflips += extract_bitflips(mapping, start_address + i + line*CACHELINE_SIZE,
+            page + line*CACHELINE_SIZE, reproducibility_mode, verbose);
+      }
+    }
+  }
+
+  free(page);
+  return found_bitflips;
+}
+
+size_t Memory::extract_bitflips(PatternAddressMapper &mapping, volatile char *line, const char *expected_line,
+                                bool reproducibility_mode, bool verbose) {
+  size_t found_bitflips = 0;
 
-    // fill comparison page with expected values generated by rand()
-    for (size_t j = 0; j < (unsigned long) pagesize/sizeof(int); ++j)
-      page[j] = rand();
+  // clear the cache to make sure we do not access a cached value
+  clflushopt(line);
+  mfence();
 
-    uint64_t addr = ((uint64_t)start_address+i);
+  // iterate over blocks of 4 bytes (=sizeof(int))
+  for (uint64_t j = 0; j < CACHELINE_SIZE; j += sizeof(int)) {
+    volatile char *cur_addr = line + j;
 
-    // check if any bit flipped in the page using the fast memcmp function, if any flip occurred we need to iterate over
-    // each byte one-by-one (much slower), otherwise we just continue with the next page
-    if ((addr+ pagesize) < ((uint64_t)start_address+size) && memcmp((void*)addr, (void*)page, pagesize) == 0)
+    // if the bit did not flip -> continue checking next block
+    int expected_rand_value = *((const int *) (expected_line + j));
+    if (*((int *) cur_addr)==expected_rand_value)
       continue;
 
-    // iterate over blocks of 4 bytes (=sizeof(int))
-    for (uint64_t j = 0; j < (uint64_t) pagesize; j += sizeof(int)) {
-      uint64_t offset = i + j;
-      volatile char *cur_addr = start_address + offset;
-
-      // if this address is outside the superpage we must not proceed to avoid segfault
-      if ((uint64_t)cur_addr >= ((uint64_t)start_address+size))
-        continue;
-
-      // clear the cache to make sure we do not access a cached value
-      clflushopt(cur_addr);
-      mfence();
-
-      // if the bit did not flip -> continue checking next block
-      int expected_rand_value = page[j/sizeof(int)];
-      if (*((int *) cur_addr)==expected_rand_value)
-        continue;
-
-      // if the bit flipped -> compare byte per byte
-      for (unsigned long c = 0; c < sizeof(int); c++) {
-        volatile char *flipped_address = cur_addr + c;
-        if (*flipped_address != ((char *) &expected_rand_value)[c]) {
-          const auto flipped_addr_dram = DRAMAddr((void *) flipped_address);
-          assert(flipped_address == (volatile char*)flipped_addr_dram.to_virt());
-          const auto flipped_addr_value = *(unsigned char *) flipped_address;
-          const auto expected_value = ((unsigned char *) &expected_rand_value)[c];
-          if (verbose) {
-            Logger::log_bitflip(flipped_address, flipped_addr_dram.row,
-                expected_value, flipped_addr_value, true);
-          }
-          // store detailed information about the bit flip
-          BitFlip bitflip(flipped_addr_dram, (expected_value ^ flipped_addr_value), flipped_addr_value);
-          // ..in the mapping that triggered this bit flip
-          if (!reproducibility_mode) {
-            if (mapping.bit_flips.empty()) {
-              Logger::log_error("Cannot store bit flips found in given address mapping.\n"
-                                "You need to create an empty vector in PatternAddressMapper::bit_flips before calling "
-                                "check_memory.");
-            }
-            mapping.bit_flips.back().push_back(bitflip);
+    // if the bit flipped -> compare byte per byte
+    for (unsigned long c = 0; c < sizeof(int); c++) {
+      volatile char *flipped_address = cur_addr + c;
+      if (*flipped_address != ((char *) &expected_rand_value)[c]) {
+        const auto flipped_addr_dram = DRAMAddr(ctx, (void *) flipped_address);
+        assert(flipped_address == (volatile char*)flipped_addr_dram.to_virt());
+        ledger.mark_restored(flipped_addr_dram);
+        const auto flipped_addr_value = *(unsigned char *) flipped_address;
+        const auto expected_value = ((unsigned char *) &expected_rand_value)[c];
+        if (verbose) {
+          Logger::log_bitflip(flipped_address, flipped_addr_dram.row,
+              expected_value, flipped_addr_value, true);
+        }
+        // store detailed information about the bit flip
+        BitFlip bitflip(flipped_addr_dram, (expected_value ^ flipped_addr_value), flipped_addr_value);
+        // ..in the mapping that triggered this bit flip
+        if (!reproducibility_mode) {
+          if (mapping.bit_flips.empty()) {
+            Logger::log_error("Cannot store bit flips found in given address mapping.\n"
+                              "You need to create an empty vector in PatternAddressMapper::bit_flips before calling "
+                              "check_memory.");
           }
-          // ..in an attribute of this class so that it can be retrived by the caller
-          flipped_bits.push_back(bitflip);
-          found_bitflips += bitflip.count_bit_corruptions();
+          mapping.bit_flips.back().push_back(bitflip);
         }
+        // ..in an attribute of this class so that it can be retrived by the caller
+        flipped_bits.push_back(bitflip);
+        found_bitflips += bitflip.count_bit_corruptions();
       }
-
-      // restore original (unflipped) value
-      *((int *) cur_addr) = expected_rand_value;
-
-      // flush this address so that value is committed before hammering again there
-      clflushopt(cur_addr);
-      mfence();
     }
+
+    // restore original (unflipped) value
+    *((int *) cur_addr) = expected_rand_value;
   }
-  
-  free(page);
+
+  // flush this line so that the restored value is committed before hammering again there
+  clflushopt(line);
+  mfence();
+
   return found_bitflips;
 }
 
-Memory::Memory(BlacksmithConfig &config, bool use_superpage) : config(config), size(0), superpage(use_superpage) {
+Memory::Memory(const TranslationContext &ctx, std::optional<uint64_t> seed, bool lazy_init)
+    : start_address(ctx.get_start_address()), ctx(ctx), size(0), lazy_init(lazy_init) {
+  if (!seed.has_value()) {
+    std::random_device rd;
+    seed = (static_cast<uint64_t>(rd()) << 32U) | rd();
+  }
+  generator = DataGenerator(seed.value());
 }
 
 Memory::~Memory() {
@@ -218,6 +592,10 @@ volatile char *Memory::get_starting_address() const {
   return start_address;
 }
 
+const TranslationContext &Memory::get_context() const {
+  return ctx;
+}
+
 std::string Memory::get_flipped_rows_text_repr() {
   // first extract all rows, otherwise it will not be possible to know in advance whether we we still
   // need to add a separator (comma) to the string as upcoming DRAMAddr instances might refer to the same row
@@ -234,6 +612,14 @@ std::string Memory::get_flipped_rows_text_repr() {
   return ss.str();
 }
 
+uint64_t Memory::get_seed() const {
+  return generator.seed;
+}
+
+size_t Memory::get_num_pages() const {
+  return size/HUGEPAGE_SIZE;
+}
+
 uint64_t Memory::get_size() const {
   return size;
 }
@@ -0,0 +1,159 @@
+#include "Memory/RefreshProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Utilities/Logger.hpp"
+
+std::string RefreshProfile::get_histogram_text() const {
+  std::string text;
+  for (size_t bin = 0; bin < interval_histogram.size(); ++bin) {
+    if (interval_histogram[bin]==0) continue;
+    const double from_us = static_cast<double>(bin)*HISTOGRAM_BIN_NS/1000;
+    text += (text.empty() ? "" : ", ");
+    text += (bin + 1 < interval_histogram.size())
+            ? format_string("[%.2f-%.2f us]: %zu", from_us, from_us + HISTOGRAM_BIN_NS/1000, interval_histogram[bin])
+            : format_string("[%.2f- us]: %zu", from_us, interval_histogram[bin]);
+  }
+  return text;
+}
+
+void to_json(nlohmann::json &j, const RefreshProfile &p) {
+  j = nlohmann::json{{"trefi_ns", p.trefi_ns},
+                     {"jitter_ns", p.jitter_ns},
+                     {"phase_stability", p.phase_stability},
+                     {"double_refresh", p.double_refresh},
+                     {"tsc_ghz", p.tsc_ghz},
+                     {"num_delays", p.num_delays},
+                     {"interval_histogram", p.interval_histogram}
+  };
+}
+
+void from_json(const nlohmann::json &j, RefreshProfile &p) {
+  j.at("trefi_ns").get_to(p.trefi_ns);
+  j.at("jitter_ns").get_to(p.jitter_ns);
+  j.at("phase_stability").get_to(p.phase_stability);
+  j.at("double_refresh").get_to(p.double_refresh);
+  j.at("tsc_ghz").get_to(p.tsc_ghz);
+  j.at("num_delays").get_to(p.num_delays);
+  j.at("interval_histogram").get_to(p.interval_histogram);
+}
+
+RefreshProfiler::RefreshProfiler(size_t capacity) : timestamps(capacity, 0) {
+}
+
+RefreshProfile RefreshProfiler::analyze(double tsc_per_ns) const {
+  RefreshProfile profile;
+  profile.tsc_ghz = tsc_per_ns;
+  profile.interval_histogram.assign(RefreshProfile::HISTOGRAM_BINS, 0);
+  const size_t n = std::min(count, timestamps.size());
+  profile.num_delays = n;
+  if (n < 2 || tsc_per_ns <= 0) return profile;
+
+  // the timestamps in ns since the oldest one still in the buffer
+  const size_t oldest = (count > timestamps.size()) ? next : 0;
+  std::vector<double> times(n);
+  for (size_t i = 0; i < n; ++i) {
+    times[i] = static_cast<double>(timestamps[(oldest + i)%timestamps.size()] - timestamps[oldest])/tsc_per_ns;
+  }
+  for (size_t i = 1; i < n; ++i) {
+    const auto bin = static_cast<size_t>((times[i] - times[i - 1])/RefreshProfile::HISTOGRAM_BIN_NS);
+    profile.interval_histogram[std::min(bin, RefreshProfile::HISTOGRAM_BINS - 1)]++;
+  }
+  if (n < MIN_DELAYS) return profile;
+
+  // a first estimate of the refresh interval: the mean of the intervals around the most frequent one (not counting the
+  // overflow bin)
+  const auto mode = std::max_element(profile.interval_histogram.begin(), profile.interval_histogram.end() - 1);
+  const double mode_ns = (static_cast<double>(mode - profile.interval_histogram.begin()) + 0.5)
+      *RefreshProfile::HISTOGRAM_BIN_NS;
+  double sum = 0;
+  size_t num = 0;
+  // the first delay of the first such interval, which is likely caused by a refresh and thus a good start to number
+  // them from; the delays before it are ignored
+  size_t start = n;
+  for (size_t i = 1; i < n; ++i) {
+    const double interval = times[i] - times[i - 1];
+    if (std::abs(interval - mode_ns) > RefreshProfile::HISTOGRAM_BIN_NS) continue;
+    sum += interval;
+    num++;
+    start = std::min(start, i - 1);
+  }
+  double period = sum/static_cast<double>(num);
+
+  // number the refreshes each delay belongs to, counting from the last delay that followed its predecessor by
+  // (almost exactly) a multiple of the estimate, which is rarely the case for delays not caused by refreshes: this
+  // keeps the numbering right even if the estimate is slightly off, and a delay that is not caused by a refresh is
+  // assigned to the nearest refresh without shifting the numbering of the following ones
+  std::vector<double> ticks(n, 0);
+  size_t anchor = start;
+  for (size_t i = start + 1; i < n; ++i) {
+    ticks[i] = ticks[anchor] + std::round((times[i] - times[anchor])/period);
+    const double intervals = (times[i] - times[i - 1])/period;
+    if (std::round(intervals) >= 1 && std::abs(intervals - std::round(intervals)) < ANCHOR_DEVIATION) anchor = i;
+  }
+
+  // fit a periodic schedule (times = offset + ticks*period) by least squares, first to all delays and then only to
+  // those close to the first fit
+  std::vector<bool> on_schedule(n, false);
+  std::fill(on_schedule.begin() + static_cast<long>(start), on_schedule.end(), true);
+  std::vector<double> deviations(n, 0);
+  double offset = 0;
+  size_t num_on_schedule = n - start;
+  for (int fit = 0; fit < 2; ++fit) {
+    double mean_tick = 0, mean_time = 0;
+    for (size_t i = start; i < n; ++i) {
+      if (!on_schedule[i]) continue;
+      mean_tick += ticks[i];
+      mean_time += times[i];
+    }
+    mean_tick /= static_cast<double>(num_on_schedule);
+    mean_time /= static_cast<double>(num_on_schedule);
+    double cov = 0, var = 0;
+    for (size_t i = start; i < n; ++i) {
+      if (!on_schedule[i]) continue;
+      cov += (ticks[i] - mean_tick)*(times[i] - mean_time);
+      var += (ticks[i] - mean_tick)*(ticks[i] - mean_tick);
+    }
+    if (var==0) return profile;
+    period = cov/var;
+    offset = mean_time - period*mean_tick;
+
+    num_on_schedule = 0;
+    for (size_t i = start; i < n; ++i) {
+      deviations[i] = times[i] - offset - ticks[i]*period;
+      on_schedule[i] = std::abs(deviations[i]) < MAX_PHASE_DEVIATION*period;
+      num_on_schedule += on_schedule[i];
+    }
+    if (num_on_schedule < 2) return profile;
+  }
+
+  // the delays not caused by refreshes that happen to be close to the schedule would inflate the jitter, so only count
+  // those within a few (robustly estimated) standard deviations of it
+  std::vector<double> abs_deviations;
+  for (size_t i = start; i < n; ++i) {
+    if (on_schedule[i]) abs_deviations.push_back(std::abs(deviations[i]));
+  }
+  std::nth_element(abs_deviations.begin(), abs_deviations.begin() + static_cast<long>(abs_deviations.size()/2),
+                   abs_deviations.end());
+  // the median absolute deviation of a normal distribution is about 0.67 standard deviations
+  const double robust_std = abs_deviations[abs_deviations.size()/2]/0.6745;
+  const double max_deviation = std::min(MAX_PHASE_DEVIATION*period, std::max(4*robust_std, 1.0));
+
+  double sum_sq = 0;
+  num_on_schedule = 0;
+  for (size_t i = start; i < n; ++i) {
+    if (std::abs(deviations[i]) >= max_deviation) continue;
+    sum_sq += deviations[i]*deviations[i];
+    num_on_schedule++;
+  }
+  profile.jitter_ns = std::sqrt(sum_sq/static_cast<double>(num_on_schedule));
+  profile.phase_stability = static_cast<double>(num_on_schedule)/static_cast<double>(n - start);
+
+  const double max_period = RefreshProfile::HISTOGRAM_BIN_NS*(RefreshProfile::HISTOGRAM_BINS - 1);
+  if (profile.phase_stability >= MIN_PHASE_STABILITY && period > 0 && period < max_period) {
+    profile.trefi_ns = period;
+    profile.double_refresh = period < 0.75*NOMINAL_TREFI_NS;
+  }
+  return profile;
+}
@@ -0,0 +1,165 @@
+#include "Memory/RegionScrubber.hpp"
+
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+#include "Utilities/CpuTopology.hpp"
+#include "Utilities/TimeHelper.hpp"
+
+RegionScrubber::RegionScrubber(Memory &memory, size_t rate_mib_per_sec)
+    : memory(memory), rate_bytes_per_sec(static_cast<double>(rate_mib_per_sec)*1024*1024) {
+}
+
+RegionScrubber::~RegionScrubber() {
+  stop();
+}
+
+void RegionScrubber::start() {
+  if (worker.joinable()) return;
+
+  // pin the hammering thread so that it cannot migrate onto the scrubber's core later on
+  const int hammer_cpu = CpuTopology::get_current_cpu();
+  CpuTopology::pin_thread(pthread_self(), hammer_cpu);
+
+  // prefer a CPU on the memory's NUMA node that does not even share a physical core with the hammering thread
+  auto candidates = CpuTopology::get_node_cpus(CpuTopology::get_numa_node(memory.get_starting_address()));
+  auto siblings = CpuTopology::get_core_siblings(hammer_cpu);
+  int scrub_cpu = -1;
+  for (const auto &cpu : candidates) {
+    if (std::find(siblings.begin(), siblings.end(), cpu)==siblings.end()) {
+      scrub_cpu = cpu;
+      break;
+    }
+  }
+  if (scrub_cpu==-1) {
+    for (const auto &cpu : candidates) {
+      if (cpu!=hammer_cpu) {
+        scrub_cpu = cpu;
+        break;
+      }
+    }
+  }
+
+  running = true;
+  paused = false;
+  worker = std::thread(&RegionScrubber::run, this);
+
+  // only run the scrubber if there is nothing else to do on its CPU
+  sched_param param{};
+  param.sched_priority = 0;
+  if (pthread_setschedparam(worker.native_handle(), SCHED_IDLE, &param)!=0)
+    Logger::log_error("Could not set the scheduling policy of the scrubber thread to SCHED_IDLE.");
+
+  if (scrub_cpu==-1) {
+    Logger::log_info("No spare CPU available, the scrubber shares the CPU with the hammering thread.");
+  } else if (!CpuTopology::pin_thread(worker.native_handle(), scrub_cpu)) {
+    Logger::log_error(format_string("Could not pin the scrubber thread to CPU %d.", scrub_cpu));
+  }
+  Logger::log_info(format_string("Started scrubber on CPU %d (hammering on CPU %d) at %.0f MiB/s.",
+      scrub_cpu, hammer_cpu, rate_bytes_per_sec/(1024*1024)));
+}
+
+void RegionScrubber::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    running = false;
+  }
+  cv.notify_all();
+  if (worker.joinable()) worker.join();
+}
+
+void RegionScrubber::pause() {
+  std::unique_lock<std::mutex> lock(mtx);
+  paused = true;
+  cv.notify_all();
+  cv.wait(lock, [this] { return !busy; });
+}
+
+void RegionScrubber::resume() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    paused = false;
+  }
+  cv.notify_all();
+}
+
+void RegionScrubber::set_mapping(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mtx);
+  mapping_id = id;
+}
+
+DRAMAddr RegionScrubber::advance() {
+  const auto &ctx = memory.get_context();
+  DRAMAddr row(ctx, next_bank, next_row, 0, next_page);
+  if (++next_row < ctx.get_row_count()) return row;
+  next_row = 0;
+  if (++next_bank < ctx.get_bank_count()) return row;
+  next_bank = 0;
+  if (++next_page < ctx.get_page_count()) return row;
+  next_page = 0;
+  completed_sweeps++;
+  return row;
+}
+
+void RegionScrubber::run() {
+  std::vector<BitFlip> flips;
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    cv.wait(lock, [this] { return !running || !paused; });
+    if (!running) break;
+
+    busy = true;
+    const auto row = advance();
+    lock.unlock();
+
+    const auto start_ts = get_timestamp_us();
+    flips.clear();
+    memory.scrub_row(row, flips);
+    const auto elapsed_us = get_timestamp_us() - start_ts;
+
+    lock.lock();
+    busy = false;
+    for (const auto &flip : flips) {
+      pending_flips.push_back(flip);
+      pending_mapping_ids.push_back(mapping_id);
+    }
+    cv.notify_all();
+
+    // throttle to the configured rate; a pause or stop request ends the wait early
+    const auto row_bytes = static_cast<double>(memory.get_context().get_lines_per_row()*CACHELINE_SIZE);
+    const auto budget_us = static_cast<int64_t>(row_bytes/rate_bytes_per_sec*1e6);
+    if (budget_us > elapsed_us) {
+      cv.wait_for(lock, std::chrono::microseconds(budget_us - elapsed_us), [this] { return !running || paused; });
+    }
+  }
+}
+
+size_t RegionScrubber::report_bitflips() {
+  std::lock_guard<std::mutex> lock(mtx);
+  size_t found_bitflips = 0;
+  for (size_t i = 0; i < pending_flips.size(); ++i) {
+    auto &flip = pending_flips[i];
+    const auto &id = pending_mapping_ids[i];
+    Logger::log_bitflip((volatile char *) flip.address.to_virt(), flip.address.row, flip.corrupted_data,
+        (unsigned char) (flip.corrupted_data ^ flip.bitmask), true);
+    flips_per_mapping[id] += flip.count_bit_corruptions();
+    Logger::log_info(format_string("Bit flip found by the scrubber outside of the victim window of mapping %s (%s), "
+                                   "%zu such bit flip(s) for this mapping so far.",
+        id.empty() ? "<none>" : id.c_str(), flip.address.to_string().c_str(), flips_per_mapping[id]));
+    found_bitflips += flip.count_bit_corruptions();
+  }
+  total_flips += found_bitflips;
+  pending_flips.clear();
+  pending_mapping_ids.clear();
+  if (found_bitflips > 0) {
+    Logger::log_info(format_string("Scrubber: %zu bit flip(s) outside of victim windows so far, %zu sweep(s) completed.",
+        total_flips, completed_sweeps));
+  }
+  return found_bitflips;
+}
+
+size_t RegionScrubber::get_total_flips() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return total_flips;
+}
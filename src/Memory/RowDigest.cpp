@@ -0,0 +1,47 @@
+#include "Memory/RowDigest.hpp"
+
+#include <nmmintrin.h>
+
+const uint32_t *const RowDigest::crc_table = RowDigest::build_table();
+const RowDigest::crc_fn RowDigest::crc_kernel = RowDigest::select_kernel();
+
+const uint32_t *RowDigest::build_table() {
+  static uint32_t table[256];
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1U) ^ ((crc & 1U) ? 0x82F63B78U : 0U);
+    table[i] = crc;
+  }
+  return table;
+}
+
+RowDigest::crc_fn RowDigest::select_kernel() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") ? crc32c_sse42 : crc32c_scalar;
+}
+
+uint32_t RowDigest::crc32c(uint32_t crc, const volatile char *data, size_t len) {
+  return crc_kernel(crc, data, len);
+}
+
+const char *RowDigest::get_kernel_name() {
+  return (crc_kernel==crc32c_sse42) ? "SSE4.2" : "scalar";
+}
+
+uint32_t RowDigest::crc32c_scalar(uint32_t crc, const volatile char *data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i) {
+    crc = (crc >> 8U) ^ crc_table[(crc ^ (uint8_t) data[i]) & 0xFFU];
+  }
+  return ~crc;
+}
+
+__attribute__((target("sse4.2")))
+uint32_t RowDigest::crc32c_sse42(uint32_t crc, const volatile char *data, size_t len) {
+  uint64_t c = ~crc;
+  auto words = (const volatile uint64_t *) data;
+  for (size_t i = 0; i < len/sizeof(uint64_t); ++i) {
+    c = _mm_crc32_u64(c, words[i]);
+  }
+  return ~((uint32_t) c);
+}
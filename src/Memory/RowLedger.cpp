@@ -0,0 +1,97 @@
+#include "Memory/RowLedger.hpp"
+
+#include "Utilities/Logger.hpp"
+
+void RowLedger::resize(const TranslationContext &context) {
+  ctx = &context;
+  num_banks = context.get_bank_count();
+  num_rows = context.get_row_count();
+  const size_t num_total = context.get_page_count()*num_banks*num_rows;
+  states.assign(num_total, 0);
+  digests.assign(num_total, 0);
+}
+
+size_t RowLedger::size() const {
+  return states.size();
+}
+
+DRAMAddr RowLedger::row_at(size_t index) const {
+  return {*ctx, (index/num_rows)%num_banks, index%num_rows, 0, index/(num_rows*num_banks)};
+}
+
+bool RowLedger::contains(const DRAMAddr &addr) const {
+  return addr.bank < num_banks && addr.row < num_rows && addr.page < states.size()/(num_banks*num_rows);
+}
+
+size_t RowLedger::index_of(const DRAMAddr &addr) const {
+  if (!contains(addr)) return states.size();
+  return (addr.page*num_banks + addr.bank)*num_rows + addr.row;
+}
+
+size_t RowLedger::index_to_update(const DRAMAddr &addr, const char *update) const {
+  const auto idx = index_of(addr);
+  if (idx==states.size()) {
+    Logger::log_error(format_string("Not marking the row (page %zu, bank %zu, row %zu) as %s, it is outside of the "
+                                    "memory pool's %zu banks and %zu rows per superpage.", addr.page, addr.bank,
+        addr.row, update, num_banks, num_rows));
+  }
+  return idx;
+}
+
+void RowLedger::mark_hammered(const DRAMAddr &addr) {
+  const auto idx = index_to_update(addr, "hammered");
+  if (idx==states.size()) return;
+  states[idx] = (states[idx] & (INITIALIZED | HAS_DIGEST)) | HAMMERED;
+  hammered_rows.push_back(idx);
+}
+
+void RowLedger::mark_verified(const DRAMAddr &addr) {
+  const auto idx = index_to_update(addr, "verified");
+  if (idx!=states.size()) states[idx] |= VERIFIED;
+}
+
+void RowLedger::mark_restored(const DRAMAddr &addr) {
+  const auto idx = index_to_update(addr, "restored");
+  if (idx!=states.size()) states[idx] |= RESTORED;
+}
+
+void RowLedger::mark_initialized(const DRAMAddr &addr) {
+  const auto idx = index_to_update(addr, "initialized");
+  if (idx!=states.size()) states[idx] |= INITIALIZED;
+}
+
+void RowLedger::mark_all_initialized() {
+  for (auto &state : states) state |= INITIALIZED;
+}
+
+bool RowLedger::is_initialized(const DRAMAddr &addr) const {
+  const auto idx = index_of(addr);
+  return idx!=states.size() && (states[idx] & INITIALIZED);
+}
+
+void RowLedger::set_digest(const DRAMAddr &addr, uint32_t digest) {
+  const auto idx = index_to_update(addr, "having a digest");
+  if (idx==states.size()) return;
+  digests[idx] = digest;
+  states[idx] |= HAS_DIGEST;
+}
+
+bool RowLedger::get_digest(const DRAMAddr &addr, uint32_t &digest) const {
+  const auto idx = index_of(addr);
+  if (idx==states.size() || !(states[idx] & HAS_DIGEST)) return false;
+  digest = digests[idx];
+  return true;
+}
+
+std::vector<DRAMAddr> RowLedger::take_dirty_rows() {
+  std::vector<DRAMAddr> dirty_rows;
+  for (const auto &idx : hammered_rows) {
+    if ((states[idx] & HAMMERED) && !(states[idx] & VERIFIED)) {
+      // make sure that a row marked multiple times is only returned once
+      states[idx] |= VERIFIED;
+      dirty_rows.push_back(row_at(idx));
+    }
+  }
+  hammered_rows.clear();
+  return dirty_rows;
+}
@@ -0,0 +1,38 @@
+#include "Memory/TimingSource.hpp"
+
+#include <algorithm>
+
+#include "GlobalDefines.hpp"
+#include "Memory/DramAnalyzer.hpp"
+
+DramTimingSource::DramTimingSource(size_t rounds) : rounds(rounds) {
+}
+
+uint64_t DramTimingSource::measure(volatile char *a, volatile char *b) {
+  return DramAnalyzer::measure_time(a, b, rounds);
+}
+
+SyntheticTimingSource::SyntheticTimingSource(const MemConfiguration &mem_config, volatile char *superpage,
+                                             uint64_t seed, double outlier_rate)
+    : mem_config(mem_config), superpage(superpage), gen(seed), outlier(outlier_rate) {
+}
+
+std::pair<size_t, size_t> SyntheticTimingSource::to_bank_row(volatile char *addr) const {
+  // bits of the mapping above the superpage are the same for both addresses and thus never tell them apart
+  const size_t offset = (size_t) (addr - superpage) & (HUGEPAGE_SIZE - 1);
+  size_t linear = 0;
+  for (size_t i = 0; i < mem_config.WIDTH; ++i) {
+    linear <<= 1ULL;
+    linear |= (size_t) __builtin_parityl(offset & mem_config.DRAM_MTX[i]);
+  }
+  return {(linear >> mem_config.BK_SHIFT) & mem_config.BK_MASK, (linear >> mem_config.ROW_SHIFT) & mem_config.ROW_MASK};
+}
+
+uint64_t SyntheticTimingSource::measure(volatile char *a, volatile char *b) {
+  num_measurements++;
+  const auto loc_a = to_bank_row(a);
+  const auto loc_b = to_bank_row(b);
+  const bool conflict = loc_a.first==loc_b.first && loc_a.second!=loc_b.second;
+  const double time = outlier(gen) ? OUTLIER_TIME : (conflict ? CONFLICT_TIME : HIT_TIME);
+  return static_cast<uint64_t>(std::max(time + noise(gen), 0.0));
+}
@@ -0,0 +1,367 @@
+#include "Memory/TranslationContext.hpp"
+
+#include <algorithm>
+#include <immintrin.h>
+#include <map>
+#include <numeric>
+#include <random>
+
+#include "GlobalDefines.hpp"
+#include "Memory/BuiltinMappings.hpp"
+#include "Utilities/GF2Matrix.hpp"
+#include "Utilities/Logger.hpp"
+#include "Utilities/PageMap.hpp"
+
+TranslationContext::TranslationContext(const BlacksmithConfig &config, volatile char *start_address,
+                                       size_t page_count)
+    : config(config),
+      mem_config(config.to_memconfig()),
+      start_address(start_address),
+      // get higher order bits above the first super page
+      base_msb((size_t) start_address & (~((size_t) HUGEPAGE_SIZE - 1UL))),
+      num_pages(page_count) {
+  build_local_matrices();
+  build_luts();
+  build_blocks(local_dram_mtx, dram_blocks);
+  build_blocks(local_addr_mtx, addr_blocks);
+  select_batch_kernel();
+  select_builtin_mapping();
+  compute_row_line_basis();
+  compute_row_bit_offsets();
+  build_bank_labels();
+  build_page_order();
+}
+
+void TranslationContext::select_builtin_mapping() {
+  for (const auto &m : get_builtin_mappings()) {
+    // the config file might have been modified after building, so the matrices must match too
+    if (mem_config.WIDTH==BUILTIN_MTX_SIZE && config.name==m.name
+        && std::equal(m.dram_mtx->begin(), m.dram_mtx->end(), mem_config.DRAM_MTX.begin())
+        && std::equal(m.addr_mtx->begin(), m.addr_mtx->end(), mem_config.ADDR_MTX.begin())
+        && config.bank_bits.size()==m.num_bank_bits && config.col_bits.size()==m.num_col_bits
+        && config.row_bits.size()==m.num_row_bits) {
+      builtin_to_dram = m.to_dram;
+      builtin_to_addr = m.to_addr;
+      return;
+    }
+  }
+}
+
+size_t TranslationContext::apply_matrix(const std::array<size_t, MAX_MTX_SIZE> &mtx, size_t v) const {
+  size_t res = 0;
+  for (size_t i = 0; i < mem_config.WIDTH; ++i) {
+    res <<= 1ULL;
+    res |= (size_t) __builtin_parityl(v & mtx[i]);
+  }
+  return res;
+}
+
+void TranslationContext::build_local_matrices() {
+  const size_t width = mem_config.WIDTH;
+  const size_t offset_mask = HUGEPAGE_SIZE - 1;
+  for (size_t r = 0; r < width; ++r) {
+    // the superpage's physical bits only contribute the page origin, which is not part of the local coordinates
+    local_dram_mtx[r] = mem_config.DRAM_MTX[r] & offset_mask;
+    // an offset within the superpage has no bits above it
+    local_addr_mtx[r] = (width - 1 - r < SUPERPAGE_BITS) ? mem_config.ADDR_MTX[r] : 0;
+  }
+
+  // a bank function without any bit of the offset within a superpage (e.g., a channel, DIMM, or rank selected by a
+  // physical address bit above 30) is constant within a superpage: its value is part of the page origin, and the banks
+  // within the superpage are those of the remaining bank bits
+  local_bank_mask = 0;
+  for (size_t bit = 0; bit < (size_t) __builtin_popcountl(mem_config.BK_MASK); ++bit) {
+    if (local_dram_mtx[width - 1 - (mem_config.BK_SHIFT + bit)]!=0) local_bank_mask |= 1ULL << bit;
+  }
+
+  // DRAMAddr enumerates banks, columns, and rows independently, hence the local coordinates must be all combinations
+  // of every local bank and column with the first rows_per_page rows, i.e., the images of the offset bits must span
+  // exactly the local bank bits, the column bits, and the lowest row bits of the linearized DRAM address
+  const size_t num_bank_col_bits = (size_t) __builtin_popcountl(local_bank_mask)
+      + (size_t) __builtin_popcountl(mem_config.COL_MASK);
+  const size_t num_row_bits = (size_t) __builtin_popcountl(mem_config.ROW_MASK);
+  if (num_bank_col_bits > SUPERPAGE_BITS || SUPERPAGE_BITS - num_bank_col_bits > num_row_bits) {
+    Logger::log_error("The bank and column bits of the config do not fit into a superpage.");
+    exit(EXIT_FAILURE);
+  }
+  const size_t local_row_bits = SUPERPAGE_BITS - num_bank_col_bits;
+  const size_t local_mask = (local_bank_mask << mem_config.BK_SHIFT) | (mem_config.COL_MASK << mem_config.COL_SHIFT)
+      | (((1ULL << local_row_bits) - 1) << mem_config.ROW_SHIFT);
+
+  GF2Matrix images(SUPERPAGE_BITS, mem_config.WIDTH);
+  for (size_t bit = 0; bit < SUPERPAGE_BITS; ++bit) {
+    const size_t image = apply_matrix(local_dram_mtx, 1ULL << bit);
+    if ((image & ~local_mask)!=0) {
+      Logger::log_error(format_string("Address bit %zu changes DRAM address bits that cannot be enumerated within a "
+                                      "superpage, the config is not supported.", bit));
+      exit(EXIT_FAILURE);
+    }
+    images.set_row(bit, image);
+  }
+  if (images.rank()!=SUPERPAGE_BITS) {
+    Logger::log_error("The offsets within a superpage do not map to distinct DRAM addresses, the config is not "
+                      "supported.");
+    exit(EXIT_FAILURE);
+  }
+  rows_per_page = 1ULL << local_row_bits;
+  if (local_bank_mask!=mem_config.BK_MASK) {
+    Logger::log_info(format_string("%d bank function(s) of the config only depend on physical address bits above the "
+                                   "superpage, each superpage covers %zu of the %zu banks.",
+        __builtin_popcountl(mem_config.BK_MASK & ~local_bank_mask), get_bank_count(), mem_config.BK_MASK + 1));
+  }
+}
+
+bool TranslationContext::get_page_origin(size_t page, size_t &origin) const {
+  origin = 0;
+  if (!is_wide()) return true;
+  uint64_t phys;
+  if (!PageMap::get_physical_address(start_address + page*HUGEPAGE_SIZE, phys)) return false;
+  origin = apply_matrix(mem_config.DRAM_MTX, phys & ~((uint64_t) HUGEPAGE_SIZE - 1));
+  return true;
+}
+
+void TranslationContext::build_luts() {
+  // only the bytes that any matrix row depends on need a table
+  size_t used_bits = 0;
+  for (size_t i = 0; i < mem_config.WIDTH; ++i) used_bits |= local_dram_mtx[i] | local_addr_mtx[i];
+  lut_slices = 0;
+  while (lut_slices < sizeof(size_t) && (used_bits >> (8*lut_slices))!=0) lut_slices++;
+
+  for (size_t s = 0; s < lut_slices; ++s) {
+    for (size_t v = 0; v < 256; ++v) {
+      dram_lut[s][v] = apply_matrix(local_dram_mtx, v << (8*s));
+      addr_lut[s][v] = apply_matrix(local_addr_mtx, v << (8*s));
+    }
+  }
+}
+
+void TranslationContext::build_blocks(const std::array<size_t, MAX_MTX_SIZE> &mtx, matrix_blocks &blocks) const {
+  // output bit o of a product is computed by matrix row WIDTH-1-o; GFNI computes bit i of an output byte as the
+  // parity of the input byte masked by byte 7-i of the block
+  for (auto &out_byte : blocks) out_byte.fill(0);
+  for (size_t o = 0; o < mem_config.WIDTH; ++o) {
+    const size_t mtx_row = mtx[mem_config.WIDTH - 1 - o];
+    for (size_t k = 0; k < sizeof(size_t); ++k) {
+      const uint64_t in_bits = (mtx_row >> (8*k)) & 0xFFU;
+      blocks[o/8][k] |= in_bits << (8*(7 - o%8));
+    }
+  }
+}
+
+void TranslationContext::select_batch_kernel() {
+  use_gfni = false;
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("gfni") || !__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw"))
+    return;
+
+  // only use the vectorized kernel if it agrees with the lookup tables on a sample of addresses
+  std::mt19937_64 gen(mem_config.WIDTH);
+  std::vector<size_t> in(256), out(in.size());
+  for (auto &v : in) v = gen();
+  for (const auto &m : {std::make_pair(&dram_lut, &dram_blocks), std::make_pair(&addr_lut, &addr_blocks)}) {
+    transform_gfni(*m.second, in.data(), out.data(), in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+      if (out[i]!=apply_lut(*m.first, in[i])) {
+        Logger::log_error("The GFNI address translation kernel disagrees with the lookup tables, not using it.");
+        return;
+      }
+    }
+  }
+  use_gfni = true;
+}
+
+const char *TranslationContext::get_batch_kernel_name() const {
+  if (builtin_to_dram) return "builtin mapping";
+  return use_gfni ? "GFNI" : "lookup table";
+}
+
+void TranslationContext::to_dram_batch(const size_t *in, size_t *out, size_t n) const {
+  if (builtin_to_dram) {
+    for (size_t i = 0; i < n; ++i) out[i] = builtin_to_dram(in[i]);
+  } else {
+    transform(dram_lut, dram_blocks, in, out, n);
+  }
+}
+
+void TranslationContext::to_addr_batch(const size_t *in, size_t *out, size_t n) const {
+  if (builtin_to_addr) {
+    for (size_t i = 0; i < n; ++i) out[i] = builtin_to_addr(in[i]);
+  } else {
+    transform(addr_lut, addr_blocks, in, out, n);
+  }
+}
+
+void TranslationContext::transform(const matrix_lut &lut, const matrix_blocks &blocks, const size_t *in, size_t *out,
+                                   size_t n) const {
+  size_t i = 0;
+  if (use_gfni) {
+    i = n - n%8;
+    transform_gfni(blocks, in, out, i);
+  }
+  for (; i < n; ++i) {
+    out[i] = apply_lut(lut, in[i]);
+  }
+}
+
+__attribute__((target("avx512f,avx512bw,gfni")))
+void TranslationContext::transform_gfni(const matrix_blocks &blocks, const size_t *in, size_t *out, size_t n) const {
+  const size_t out_bytes = (mem_config.WIDTH + 7)/8;
+  for (size_t i = 0; i + 8 <= n; i += 8) {
+    const __m512i src = _mm512_loadu_si512((const void *) (in + i));
+    __m512i acc = _mm512_setzero_si512();
+    for (size_t k = 0; k < lut_slices; ++k) {
+      // replicate input byte k of each of the 8 vectors to all bytes of its lane
+      const auto lo = (long long) (k*0x0101010101010101ULL);
+      const auto hi = (long long) ((k + 8)*0x0101010101010101ULL);
+      const __m512i in_byte = _mm512_shuffle_epi8(src, _mm512_set4_epi64(hi, lo, hi, lo));
+      for (size_t j = 0; j < out_bytes; ++j) {
+        if (blocks[j][k]==0) continue;
+        // only output byte j of each lane is computed by this block
+        const __mmask64 out_mask = 0x0101010101010101ULL << j;
+        acc = _mm512_xor_si512(acc, _mm512_maskz_gf2p8affine_epi64_epi8(out_mask, in_byte,
+            _mm512_set1_epi64((long long) blocks[j][k]), 0));
+      }
+    }
+    _mm512_storeu_si512((void *) (out + i), acc);
+  }
+}
+
+void TranslationContext::compute_row_line_basis() {
+  // the mapping is linear over GF(2), hence the addresses of a row are the address of its column 0 XORed with any
+  // combination of the addresses the individual column bits map to; dropping the offset within the cache line from
+  // these and reducing them to a basis yields every cache line of the row exactly once
+  row_line_basis.clear();
+  for (size_t bit = 0; bit < (size_t) __builtin_popcountl(mem_config.COL_MASK); ++bit) {
+    size_t image = apply_matrix(local_addr_mtx, 1ULL << (mem_config.COL_SHIFT + bit));
+    image &= ~(CACHELINE_SIZE - 1);
+
+    // Gaussian elimination: only keep the vector if it is independent of the ones collected so far
+    for (const auto &b : row_line_basis) {
+      image = std::min(image, image ^ b);
+    }
+    if (image!=0) {
+      row_line_basis.push_back(image);
+      // keep the basis sorted in descending order so that the reduction above works
+      std::sort(row_line_basis.begin(), row_line_basis.end(), std::greater<>());
+    }
+  }
+}
+
+void TranslationContext::compute_row_bit_offsets() {
+  // the mapping is linear, so changing a bit of the row number always changes the address by the same value
+  row_bit_offsets.clear();
+  for (size_t bit = 0; (1ULL << bit) < rows_per_page; ++bit) {
+    row_bit_offsets.push_back(apply_matrix(local_addr_mtx, 1ULL << (mem_config.ROW_SHIFT + bit)));
+  }
+}
+
+void TranslationContext::build_bank_labels() {
+  const size_t num_bank_bits = config.bank_bits.size();
+  const std::array<std::pair<const std::vector<size_t> *, const char *>, 4> labels = {{
+      {&config.channel_bits, "channel_bits"},
+      {&config.dimm_bits, "dimm_bits"},
+      {&config.rank_bits, "rank_bits"},
+      {&config.bank_group_bits, "bank_group_bits"}}};
+
+  std::vector<bool> labelled(num_bank_bits, false);
+  spread_order.clear();
+  for (size_t l = 0; l < labels.size(); ++l) {
+    label_bits[l].clear();
+    for (const auto &idx : *labels[l].first) {
+      if (idx >= num_bank_bits || labelled[idx]) {
+        Logger::log_error(format_string("%s of the config refers to bank function %zu, which does not exist or is "
+                                        "already labelled.", labels[l].second, idx));
+        exit(EXIT_FAILURE);
+      }
+      labelled[idx] = true;
+      // bank_bits[0] is the most significant bit of the bank, like the first row of DRAM_MTX
+      label_bits[l].push_back(num_bank_bits - 1 - idx);
+    }
+    // the least significant bit of each label should change first
+    spread_order.insert(spread_order.end(), label_bits[l].rbegin(), label_bits[l].rend());
+  }
+  for (size_t pos = 0; pos < num_bank_bits; ++pos) {
+    if (!labelled[num_bank_bits - 1 - pos]) spread_order.push_back(pos);
+  }
+  // only the bank bits within a superpage can be rotated through, the others are fixed by the superpage's origin
+  origin_spread_order.clear();
+  std::copy_if(spread_order.begin(), spread_order.end(), std::back_inserter(origin_spread_order),
+      [this](size_t pos) { return ((local_bank_mask >> pos) & 1ULL)==0; });
+  spread_order.erase(std::remove_if(spread_order.begin(), spread_order.end(),
+      [this](size_t pos) { return ((local_bank_mask >> pos) & 1ULL)==0; }), spread_order.end());
+
+  const std::array<std::pair<size_t, uint64_t>, 3> expected_counts = {{
+      {(size_t) BankLabel::CHANNEL, config.channels},
+      {(size_t) BankLabel::DIMM, config.dimms},
+      {(size_t) BankLabel::RANK, config.ranks}}};
+  for (const auto &e : expected_counts) {
+    if (!label_bits[e.first].empty() && (1ULL << label_bits[e.first].size())!=e.second) {
+      Logger::log_info(format_string("%s of the config select %zu values, but the config declares %lu.",
+          labels[e.first].second, 1ULL << label_bits[e.first].size(), e.second));
+    }
+  }
+}
+
+bool TranslationContext::has_bank_labels() const {
+  return std::any_of(label_bits.begin(), label_bits.end(), [](const auto &bits) { return !bits.empty(); });
+}
+
+size_t TranslationContext::get_bank_label(size_t bank, BankLabel label) const {
+  size_t res = 0;
+  for (const auto &pos : label_bits[(size_t) label]) {
+    res = (res << 1) | ((bank >> pos) & 1ULL);
+  }
+  return res;
+}
+
+size_t TranslationContext::spread_bank(size_t i) const {
+  size_t bank = 0;
+  for (size_t b = 0; b < spread_order.size(); ++b) {
+    bank |= ((i >> b) & 1ULL) << spread_order[b];
+  }
+  return compress_bank(bank);
+}
+
+void TranslationContext::build_page_order() {
+  page_order.resize(num_pages);
+  std::iota(page_order.begin(), page_order.end(), 0);
+  if (origin_spread_order.empty()) return;
+
+  // group the superpages by the values of the bank bits their origins select, numbered like spread_bank numbers the
+  // banks within a superpage
+  std::map<size_t, std::vector<size_t>> groups;
+  for (size_t page = 0; page < num_pages; ++page) {
+    size_t origin;
+    if (!get_page_origin(page, origin)) return;
+    const size_t bank_bits = (origin >> mem_config.BK_SHIFT) & mem_config.BK_MASK;
+    size_t key = 0;
+    for (size_t b = 0; b < origin_spread_order.size(); ++b) {
+      key |= ((bank_bits >> origin_spread_order[b]) & 1ULL) << b;
+    }
+    groups[key].push_back(page);
+  }
+
+  // take one superpage of each group in turn
+  page_order.clear();
+  for (size_t round = 0; page_order.size() < num_pages; ++round) {
+    for (const auto &group : groups) {
+      if (round < group.second.size()) page_order.push_back(group.second[round]);
+    }
+  }
+  Logger::log_info(format_string("The %zu superpage(s) cover %zu of the %zu values of the bank functions that only "
+                                 "depend on physical address bits above the superpage.", num_pages, groups.size(),
+      1ULL << origin_spread_order.size()));
+}
+
+#ifdef ENABLE_JSON
+
+nlohmann::json TranslationContext::get_memcfg_json() const {
+  nlohmann::json j;
+  j["channels"] = config.channels;
+  j["dimms"] = config.dimms;
+  j["ranks"] = config.ranks;
+  j["banks"] = config.total_banks;
+  return j;
+}
+
+#endif
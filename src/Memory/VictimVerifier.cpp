@@ -0,0 +1,60 @@
+#include "Memory/VictimVerifier.hpp"
+
+#include <cstring>
+#include <immintrin.h>
+
+const VictimVerifier::compare_fn VictimVerifier::compare_kernel = VictimVerifier::select_kernel();
+
+VictimVerifier::compare_fn VictimVerifier::select_kernel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return compare_lines_avx512;
+  if (__builtin_cpu_supports("avx2")) return compare_lines_avx2;
+  return compare_lines_scalar;
+}
+
+uint64_t VictimVerifier::compare_lines(const volatile char *actual, const char *expected, size_t num_lines) {
+  return compare_kernel(actual, expected, num_lines);
+}
+
+const char *VictimVerifier::get_kernel_name() {
+  if (compare_kernel==compare_lines_avx512) return "AVX-512";
+  if (compare_kernel==compare_lines_avx2) return "AVX2";
+  return "scalar";
+}
+
+uint64_t VictimVerifier::compare_lines_scalar(const volatile char *actual, const char *expected, size_t num_lines) {
+  uint64_t mismatches = 0;
+  for (size_t i = 0; i < num_lines && i < 64; ++i) {
+    if (memcmp((const void *) (actual + i*CACHELINE_SIZE), expected + i*CACHELINE_SIZE, CACHELINE_SIZE)!=0)
+      mismatches |= (1ULL << i);
+  }
+  return mismatches;
+}
+
+__attribute__((target("avx2")))
+uint64_t VictimVerifier::compare_lines_avx2(const volatile char *actual, const char *expected, size_t num_lines) {
+  uint64_t mismatches = 0;
+  for (size_t i = 0; i < num_lines && i < 64; ++i) {
+    auto a = (const __m256i *) (actual + i*CACHELINE_SIZE);
+    auto e = (const __m256i *) (expected + i*CACHELINE_SIZE);
+    // a line is equal iff all 64 bytes compare equal, i.e., both halves produce an all-ones byte mask
+    __m256i eq = _mm256_and_si256(
+        _mm256_cmpeq_epi8(_mm256_load_si256(a), _mm256_load_si256(e)),
+        _mm256_cmpeq_epi8(_mm256_load_si256(a + 1), _mm256_load_si256(e + 1)));
+    if (_mm256_movemask_epi8(eq)!=-1)
+      mismatches |= (1ULL << i);
+  }
+  return mismatches;
+}
+
+__attribute__((target("avx512f")))
+uint64_t VictimVerifier::compare_lines_avx512(const volatile char *actual, const char *expected, size_t num_lines) {
+  uint64_t mismatches = 0;
+  for (size_t i = 0; i < num_lines && i < 64; ++i) {
+    __m512i a = _mm512_load_si512((const void *) (actual + i*CACHELINE_SIZE));
+    __m512i e = _mm512_load_si512((const void *) (expected + i*CACHELINE_SIZE));
+    if (_mm512_cmpneq_epi64_mask(a, e)!=0)
+      mismatches |= (1ULL << i);
+  }
+  return mismatches;
+}
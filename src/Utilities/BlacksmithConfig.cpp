@@ -7,12 +7,11 @@
 
 #include "Utilities/BlacksmithConfig.hpp"
 #include "nlohmann/json.hpp"
-#include "Eigen/Core"
-#include "Eigen/LU"
+#include "Utilities/GF2Matrix.hpp"
 #include "Utilities/Logger.hpp"
-#include "Memory/DRAMAddr.hpp"
+#include "Memory/TranslationContext.hpp"
 
-#define BIT_SET(x, b) (x |= 1<<(b))
+#define BIT_SET(x, b) (x |= 1ULL<<(b))
 
 // helper type for std::visit
 template<class... Ts>
@@ -32,6 +31,15 @@ BlacksmithConfig BlacksmithConfig::from_jsonfile(const std::string &filepath) {
   return j.get<BlacksmithConfig>();
 }
 
+void BlacksmithConfig::to_jsonfile(const std::string &filepath) const {
+  std::ofstream os(filepath);
+  if (!os) {
+    Logger::log_error(format_string("Could not write config file %s.", filepath.c_str()));
+    exit(EXIT_FAILURE);
+  }
+  os << nlohmann::json(*this).dump(2) << std::endl;
+}
+
 /**
  * Convert a BitDef to the bit string it represents
  * @param def a BitDef
@@ -52,21 +60,28 @@ static size_t bitdef_to_bitstr(const BitDef &def) {
   return res;
 }
 
-MemConfiguration BlacksmithConfig::to_memconfig() {
+MemConfiguration BlacksmithConfig::to_memconfig() const {
   MemConfiguration out{};
   size_t i = 0;
 
-  assert(MTX_SIZE == bank_bits.size() + col_bits.size() + row_bits.size());
+  // the matrices are square, hence the mapping covers as many address bits as there are bank, column, and row bits
+  const size_t width = bank_bits.size() + col_bits.size() + row_bits.size();
+  if (width < SUPERPAGE_BITS || width > MAX_MTX_SIZE) {
+    Logger::log_error(format_string("The config defines %zu bank, column, and row bits, but %u to %u are supported.",
+        width, SUPERPAGE_BITS, MAX_MTX_SIZE));
+    exit(EXIT_FAILURE);
+  }
+  out.WIDTH = width;
 
-  out.BK_SHIFT = MTX_SIZE - bank_bits.size();
-  out.BK_MASK = (1 << (bank_bits.size())) - 1;
-  out.COL_SHIFT = MTX_SIZE - bank_bits.size() - col_bits.size();
-  out.COL_MASK = (1 << (col_bits.size())) - 1;
-  out.ROW_SHIFT = MTX_SIZE - bank_bits.size() - col_bits.size() - row_bits.size();
-  out.ROW_MASK = (1 << (row_bits.size())) - 1;
+  out.BK_SHIFT = width - bank_bits.size();
+  out.BK_MASK = (1ULL << (bank_bits.size())) - 1;
+  out.COL_SHIFT = width - bank_bits.size() - col_bits.size();
+  out.COL_MASK = (1ULL << (col_bits.size())) - 1;
+  out.ROW_SHIFT = width - bank_bits.size() - col_bits.size() - row_bits.size();
+  out.ROW_MASK = (1ULL << (row_bits.size())) - 1;
 
   // construct dram matrix
-  std::array<size_t, MTX_SIZE> dramMtx{};
+  std::array<size_t, MAX_MTX_SIZE> dramMtx{};
   auto updateDramMtx = [&i, &dramMtx](const BitDef &def) {
     dramMtx[i++] = bitdef_to_bitstr(def);
   };
@@ -78,27 +93,69 @@ MemConfiguration BlacksmithConfig::to_memconfig() {
   std::for_each(row_bits.begin(), row_bits.end(), updateDramMtx);
   out.DRAM_MTX = dramMtx;
 
-  // construct addr matrix
-  std::array<size_t, MTX_SIZE> addrMtx{};
-  // create dram matrix in eigen
-  Eigen::Matrix<bool, MTX_SIZE, MTX_SIZE> matrix(MTX_SIZE, MTX_SIZE);
-  for (long row = 0; row < MTX_SIZE; ++row) {
-    for (long col = 0; col < MTX_SIZE; ++col) {
-      matrix(row, col) = (dramMtx[row] >> (MTX_SIZE - col - 1)) & 1;
+  // the address bits are the columns of the matrix, so all of them must be below its width
+  const size_t addr_mask = (width==64) ? ~0ULL : (1ULL << width) - 1;
+  for (size_t row = 0; row < width; ++row) {
+    if ((dramMtx[row] & ~addr_mask)!=0) {
+      Logger::log_error(format_string("The config refers to address bits above bit %zu.", width - 1));
+      exit(EXIT_FAILURE);
     }
   }
+
+  // construct addr matrix: row r of DRAM_MTX computes DRAM address bit width-1-r, i.e., it is row width-1-r of the
+  // mapping as a GF2Matrix
+  GF2Matrix matrix(width, width);
+  for (size_t row = 0; row < width; ++row) {
+    matrix.set_row(width - 1 - row, dramMtx[row]);
+  }
   // invert dram matrix, assign addr matrix
-  Eigen::FullPivLU<Eigen::Matrix<double, MTX_SIZE, MTX_SIZE>> matrixDecomp(matrix.cast<double>());
-  if(!matrixDecomp.isInvertible()) {
+  GF2Matrix inverse;
+  if (!matrix.inverse(inverse)) {
     Logger::log_error("The matrix defined in the config file is not invertible.");
     exit(EXIT_FAILURE);
   }
-  matrix = matrixDecomp.inverse().cast<bool>();
-  for (long row = 0; row < MTX_SIZE; ++row) {
-    for (long col = 0; col < MTX_SIZE; ++col) {
-      addrMtx[row] |= matrix(row, col) << (MTX_SIZE - col - 1);
-    }
+  std::array<size_t, MAX_MTX_SIZE> addrMtx{};
+  for (size_t row = 0; row < width; ++row) {
+    addrMtx[width - 1 - row] = inverse.get_row(row);
   }
   out.ADDR_MTX = addrMtx;
   return out;
 }
+
+void to_json(nlohmann::json &j, const BlacksmithConfig &c) {
+  j = nlohmann::json{{"name", c.name},
+                     {"channels", c.channels},
+                     {"dimms", c.dimms},
+                     {"ranks", c.ranks},
+                     {"total_banks", c.total_banks},
+                     {"row_bits", c.row_bits},
+                     {"col_bits", c.col_bits},
+                     {"bank_bits", c.bank_bits},
+                     {"channel_bits", c.channel_bits},
+                     {"dimm_bits", c.dimm_bits},
+                     {"rank_bits", c.rank_bits},
+                     {"bank_group_bits", c.bank_group_bits}
+  };
+}
+
+void from_json(const nlohmann::json &j, BlacksmithConfig &c) {
+  j.at("name").get_to(c.name);
+  j.at("channels").get_to(c.channels);
+  j.at("dimms").get_to(c.dimms);
+  j.at("ranks").get_to(c.ranks);
+  j.at("total_banks").get_to(c.total_banks);
+  j.at("row_bits").get_to(c.row_bits);
+  j.at("col_bits").get_to(c.col_bits);
+  j.at("bank_bits").get_to(c.bank_bits);
+  // the labels are optional, configs without them treat the bank as a whole
+  for (const auto &label : {std::make_pair("channel_bits", &c.channel_bits),
+                            std::make_pair("dimm_bits", &c.dimm_bits),
+                            std::make_pair("rank_bits", &c.rank_bits),
+                            std::make_pair("bank_group_bits", &c.bank_group_bits)}) {
+    if (j.contains(label.first)) {
+      j.at(label.first).get_to(*label.second);
+    } else {
+      label.second->clear();
+    }
+  }
+}
@@ -0,0 +1,94 @@
+#include "Utilities/CpuTopology.hpp"
+
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+std::vector<int> CpuTopology::parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) continue;
+    auto dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last = (dash==std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    } catch (const std::exception &) {
+      // ignore malformed entries, the caller falls back to all CPUs if nothing could be parsed
+    }
+  }
+  return cpus;
+}
+
+int CpuTopology::get_numa_node(volatile void *address) {
+  int node = -1;
+  // glibc does not wrap get_mempolicy, and we do not want to depend on libnuma just for this call
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0, (void *) address, MPOL_F_NODE | MPOL_F_ADDR)!=0)
+    return -1;
+  return node;
+}
+
+std::vector<int> CpuTopology::get_node_cpus(int node) {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed)!=0) return {};
+
+  std::vector<int> cpus;
+  if (node >= 0) {
+    std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (ifs && std::getline(ifs, list)) {
+      for (const auto &cpu : parse_cpu_list(list)) {
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+      }
+    }
+  }
+
+  if (cpus.empty()) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::vector<int> CpuTopology::get_core_siblings(int cpu) {
+  std::ifstream ifs("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+  std::string list;
+  if (ifs && std::getline(ifs, list)) {
+    auto siblings = parse_cpu_list(list);
+    if (!siblings.empty()) return siblings;
+  }
+  return {cpu};
+}
+
+int CpuTopology::get_current_cpu() {
+  return sched_getcpu();
+}
+
+bool CpuTopology::pin_thread(pthread_t thread, int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(thread, sizeof(set), &set)==0;
+}
+
+std::string CpuTopology::get_cpu_info(const std::string &field) {
+  std::ifstream ifs("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(ifs, line)) {
+    // lines look like "model name\t: Intel(R) Core(TM) i7-8700K CPU @ 3.70GHz"
+    const auto colon = line.find(':');
+    if (colon==std::string::npos || colon==0) continue;
+    const auto name_end = line.find_last_not_of(" \t", colon - 1);
+    if (name_end==std::string::npos || line.substr(0, name_end + 1)!=field) continue;
+    const auto value_start = line.find_first_not_of(' ', colon + 1);
+    return (value_start==std::string::npos) ? "" : line.substr(value_start);
+  }
+  return "";
+}
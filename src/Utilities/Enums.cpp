@@ -41,6 +41,34 @@ void from_string(const std::string &strategy, FENCING_STRATEGY &dest) {
   dest = map.at(strategy);
 }
 
+std::string to_string(DATA_PATTERN pattern) {
+  std::map<DATA_PATTERN, std::string> map =
+      {
+          {DATA_PATTERN::ZEROES, "ZEROES"},
+          {DATA_PATTERN::ONES, "ONES"},
+          {DATA_PATTERN::RANDOM, "RANDOM"},
+          {DATA_PATTERN::ROW_STRIPE, "ROW_STRIPE"},
+          {DATA_PATTERN::CHECKERBOARD, "CHECKERBOARD"},
+          {DATA_PATTERN::COLUMN_STRIPE, "COLUMN_STRIPE"},
+          {DATA_PATTERN::AGGRESSOR_INVERSE, "AGGRESSOR_INVERSE"}
+      };
+  return map.at(pattern);
+}
+
+void from_string(const std::string &pattern, DATA_PATTERN &dest) {
+  std::map<std::string, DATA_PATTERN> map =
+      {
+          {"ZEROES", DATA_PATTERN::ZEROES},
+          {"ONES", DATA_PATTERN::ONES},
+          {"RANDOM", DATA_PATTERN::RANDOM},
+          {"ROW_STRIPE", DATA_PATTERN::ROW_STRIPE},
+          {"CHECKERBOARD", DATA_PATTERN::CHECKERBOARD},
+          {"COLUMN_STRIPE", DATA_PATTERN::COLUMN_STRIPE},
+          {"AGGRESSOR_INVERSE", DATA_PATTERN::AGGRESSOR_INVERSE}
+      };
+  dest = map.at(pattern);
+}
+
 [[maybe_unused]] std::pair<FLUSHING_STRATEGY, FENCING_STRATEGY> get_valid_strategy_pair() {
   auto valid_strategies = get_valid_strategies();
   auto num_strategies = valid_strategies.size();
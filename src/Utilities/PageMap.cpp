@@ -0,0 +1,23 @@
+#include "Utilities/PageMap.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+bool PageMap::get_physical_address(const volatile void *address, uint64_t &physical_address) {
+  const auto page_size = (uint64_t) sysconf(_SC_PAGESIZE);
+  const auto virt = (uint64_t) address;
+
+  // opened once and kept open for the lifetime of the process, the initialization of a function-local static is
+  // thread-safe and pread does not share a file offset between threads
+  static const int fd = open("/proc/self/pagemap", O_RDONLY);
+  if (fd < 0) return false;
+  // one 64-bit entry per page: bit 63 is set if the page is present, bits 0-54 hold the page frame number
+  uint64_t entry = 0;
+  const auto offset = (off_t) (virt/page_size*sizeof(entry));
+  const bool ok = pread(fd, &entry, sizeof(entry), offset)==sizeof(entry);
+
+  const uint64_t pfn = entry & ((1ULL << 55) - 1);
+  if (!ok || !(entry & (1ULL << 63)) || pfn==0) return false;
+  physical_address = pfn*page_size + virt%page_size;
+  return true;
+}
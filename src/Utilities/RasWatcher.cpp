@@ -26,16 +26,27 @@ int RasWatcher::report_corrected_bitflips(PatternAddressMapper &mapping) {
   Logger::log_info("Checking Rasdaemon database for ECC corrections.");
   int new_corrections = fetch_new_corrections();
   mapping.corrected_bit_flips += new_corrections;
-  if (new_corrections > 0)
+  if (new_corrections > 0) {
     Logger::log_corrected_bitflip(new_corrections);
+    for (const auto &entry : new_corrections_per_label) {
+      Logger::log_info(format_string("%d correction(s) on %s.", entry.second, entry.first.c_str()));
+      corrections_per_label[entry.first] += entry.second;
+    }
+  }
   return new_corrections;
 }
 
+const std::map<std::string, int> &RasWatcher::get_corrections_per_label() const {
+  return corrections_per_label;
+}
+
 int RasWatcher::fetch_new_corrections() {
-  std::string query = "SELECT COUNT(*) FROM mc_event;";
-  int ret, new_total_corrections;
+  std::string query = "SELECT IFNULL(label, 'unknown'), COUNT(*) FROM mc_event GROUP BY label;";
+  int ret;
+  std::map<std::string, int> new_totals;
   while (true) {
-    ret = sqlite3_exec(ras_db, query.c_str(), callback, &new_total_corrections, NULL);
+    new_totals.clear();
+    ret = sqlite3_exec(ras_db, query.c_str(), callback, &new_totals, NULL);
     if (ret == SQLITE_BUSY)
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
     else {
@@ -43,12 +54,20 @@ int RasWatcher::fetch_new_corrections() {
       break;
     }
   }
+  int new_total_corrections = 0;
+  new_corrections_per_label.clear();
+  for (const auto &entry : new_totals) {
+    new_total_corrections += entry.second;
+    int increase = entry.second - total_corrections_per_label[entry.first];
+    if (increase > 0) new_corrections_per_label[entry.first] = increase;
+  }
+  total_corrections_per_label = new_totals;
   int increase_in_corrections = new_total_corrections - total_corrections;
   total_corrections = new_total_corrections;
   return increase_in_corrections;
 }
 
 int RasWatcher::callback(void *value, int, char **data, char **) {
-  *(int*)value = atoi(data[0]);
+  (*(std::map<std::string, int>*)value)[data[0]] += atoi(data[1]);
   return 0;
 }
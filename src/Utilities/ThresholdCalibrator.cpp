@@ -0,0 +1,89 @@
+#include "Utilities/ThresholdCalibrator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ThresholdCalibrator::ThresholdCalibrator(size_t min_mode_samples, double min_separation)
+    : min_mode_samples(min_mode_samples), min_separation(min_separation), histogram(MAX_LATENCY, 0) {
+}
+
+void ThresholdCalibrator::add(uint64_t latency) {
+  num_samples++;
+  if (latency >= MAX_LATENCY) {
+    num_outliers++;
+    return;
+  }
+  histogram[latency]++;
+  if (latency < min_latency) min_latency = latency;
+  if (latency > max_latency) max_latency = latency;
+}
+
+void ThresholdCalibrator::update() {
+  previous_threshold = threshold;
+  const size_t total = num_samples - num_outliers;
+  if (total==0) return;
+
+  double total_sum = 0;
+  for (size_t lat = min_latency; lat <= max_latency; ++lat) total_sum += static_cast<double>(lat*histogram[lat]);
+
+  // Otsu's method: try every threshold and keep the one with the largest variance between the two classes; all
+  // thresholds within a gap between the modes are equally good, so take the middle of the gap
+  double best_variance = -1;
+  size_t best_first = 0, best_last = 0;
+  size_t count = 0;
+  double sum = 0;
+  for (size_t lat = min_latency; lat < max_latency; ++lat) {
+    count += histogram[lat];
+    sum += static_cast<double>(lat*histogram[lat]);
+    if (count==0 || count==total) continue;
+    const double w_fast = static_cast<double>(count), w_slow = static_cast<double>(total - count);
+    const double mean_diff = sum/w_fast - (total_sum - sum)/w_slow;
+    const double variance = w_fast*w_slow*mean_diff*mean_diff;
+    if (variance > best_variance) {
+      best_variance = variance;
+      best_first = best_last = lat;
+    } else if (variance==best_variance) {
+      best_last = lat;
+    }
+  }
+  threshold = best_first + (best_last - best_first)/2;
+  if (best_variance < 0) {
+    // all samples have the same latency, so there is only one mode
+    threshold = max_latency;
+    fast_count = total;
+    slow_count = 0;
+    separation = 0;
+    return;
+  }
+
+  // the statistics of both modes to judge how well they are separated
+  double fast_sum = 0, fast_sq = 0, slow_sum = 0, slow_sq = 0;
+  fast_count = slow_count = 0;
+  for (size_t lat = min_latency; lat <= max_latency; ++lat) {
+    const auto n = static_cast<double>(histogram[lat]);
+    const auto l = static_cast<double>(lat);
+    if (lat <= threshold) {
+      fast_count += histogram[lat];
+      fast_sum += n*l;
+      fast_sq += n*l*l;
+    } else {
+      slow_count += histogram[lat];
+      slow_sum += n*l;
+      slow_sq += n*l*l;
+    }
+  }
+  fast_mean = fast_sum/static_cast<double>(fast_count);
+  slow_mean = slow_sum/static_cast<double>(slow_count);
+  const double fast_var = fast_sq/static_cast<double>(fast_count) - fast_mean*fast_mean;
+  const double slow_var = slow_sq/static_cast<double>(slow_count) - slow_mean*slow_mean;
+  // a mode of a single latency has no variance, assume the resolution of the histogram instead
+  const double pooled_std = std::sqrt(std::max((fast_var + slow_var)/2, 1.0));
+  separation = (slow_mean - fast_mean)/pooled_std;
+}
+
+bool ThresholdCalibrator::is_separated() {
+  update();
+  const auto moved = static_cast<size_t>(std::abs(static_cast<long>(threshold) - static_cast<long>(previous_threshold)));
+  return fast_count >= min_mode_samples && slow_count >= min_mode_samples && separation >= min_separation
+      && moved*100 <= threshold;
+}
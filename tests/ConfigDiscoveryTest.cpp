@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "GlobalDefines.hpp"
+#include "Memory/ConfigDiscovery.hpp"
+#include "Memory/TimingSource.hpp"
+#include "Memory/TranslationContext.hpp"
+#include "Utilities/BlacksmithConfig.hpp"
+
+// the bits of each definition (a single bit or the bits XORed by a function) as a mask, keeping only the bits within a
+// superpage, which are all that timing within a superpage can tell apart
+static std::vector<uint64_t> to_masks(const std::vector<BitDef> &defs) {
+  std::vector<uint64_t> masks;
+  for (const auto &def : defs) {
+    uint64_t mask = 0;
+    if (std::holds_alternative<uint64_t>(def)) {
+      mask = 1ULL << std::get<uint64_t>(def);
+    } else {
+      for (auto bit : std::get<std::vector<uint64_t>>(def)) mask |= 1ULL << bit;
+    }
+    mask &= (1ULL << SUPERPAGE_BITS) - 1;
+    if (mask!=0) masks.push_back(mask);
+  }
+  std::sort(masks.begin(), masks.end());
+  return masks;
+}
+
+static bool check_bits(const std::string &name, const char *kind, const std::vector<BitDef> &expected,
+                       const std::vector<BitDef> &actual) {
+  if (to_masks(expected)==to_masks(actual)) return true;
+  std::fprintf(stderr, "%s: discovered %s %s instead of %s.\n", name.c_str(), kind,
+               nlohmann::json(actual).dump().c_str(), nlohmann::json(expected).dump().c_str());
+  return false;
+}
+
+// Checks that ConfigDiscovery recovers the row bits, column bits, and bank functions of each given config from a
+// synthetic timing oracle that answers like DRAM with the config's mapping, including noise and outliers.
+// Usage: test_config_discovery <config file>...
+int main(int argc, char **argv) {
+  auto superpage = (volatile char *) (64*(size_t) HUGEPAGE_SIZE);
+  bool ok = true;
+
+  for (int arg = 1; arg < argc; ++arg) {
+    const BlacksmithConfig config = BlacksmithConfig::from_jsonfile(argv[arg]);
+    const TranslationContext ctx(config, superpage, 1);
+    SyntheticTimingSource oracle(ctx.get_mem_config(), superpage, arg);
+    ConfigDiscovery discovery(superpage, oracle, arg);
+    const BlacksmithConfig discovered = discovery.discover(config.name);
+    std::printf("%s: discovered with %zu measurements\n", config.name.c_str(), discovery.get_num_measurements());
+
+    // the discovery lists the bank functions in a basis with as few bits per function as possible, which is the one
+    // of the shipped configs
+    ok &= check_bits(config.name, "row bits", config.row_bits, discovered.row_bits);
+    ok &= check_bits(config.name, "column bits", config.col_bits, discovered.col_bits);
+    ok &= check_bits(config.name, "bank functions", config.bank_bits, discovered.bank_bits);
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
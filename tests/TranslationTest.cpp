@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "GlobalDefines.hpp"
+#include "Memory/BuiltinMappings.hpp"
+#include "Memory/DRAMAddr.hpp"
+#include "Memory/TranslationContext.hpp"
+#include "Utilities/BlacksmithConfig.hpp"
+
+// the number of random offsets translated per config, not a multiple of 8 so that the batch kernels' tails are covered
+static const size_t NUM_ADDRESSES = (1 << 16) + 5;
+
+// the product with a matrix in the format of MemConfiguration, computed one parity per output bit
+static size_t apply_bitwise(const std::array<size_t, MAX_MTX_SIZE> &mtx, size_t width, size_t v) {
+  size_t res = 0;
+  for (size_t i = 0; i < width; ++i) {
+    res <<= 1ULL;
+    res |= (size_t) __builtin_parityl(v & mtx[i]);
+  }
+  return res;
+}
+
+// checks that DRAMAddr maps every address to coordinates within the superpage's banks and rows and back
+static bool check_dram_addrs(const std::string &name, const TranslationContext &ctx, const std::vector<size_t> &addrs) {
+  std::vector<DRAMAddr> dram_addrs(addrs.size());
+  DRAMAddr::from_virt_batch(ctx, (volatile char *const *) addrs.data(), addrs.size(), dram_addrs.data());
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    const DRAMAddr &a = dram_addrs[i];
+    if (a.bank < ctx.get_bank_count() && a.row < ctx.get_row_count() && (size_t) a.to_virt()==addrs[i]
+        && DRAMAddr(ctx, (void *) addrs[i]).bank==a.bank) continue;
+    std::fprintf(stderr, "%s maps %zx to bank %zu (of %zu), row %zu (of %zu), which maps back to %p.\n", name.c_str(),
+                 addrs[i], a.bank, ctx.get_bank_count(), a.row, ctx.get_row_count(), a.to_virt());
+    return false;
+  }
+  return true;
+}
+
+// checks that the rotations over the banks and superpages visit each of them exactly once
+static bool check_rotations(const std::string &name, const TranslationContext &ctx) {
+  std::set<size_t> banks, pages;
+  for (size_t i = 0; i < ctx.get_bank_count(); ++i) {
+    if (ctx.spread_bank(i) < ctx.get_bank_count()) banks.insert(ctx.spread_bank(i));
+  }
+  for (size_t i = 0; i < ctx.get_page_count(); ++i) {
+    if (ctx.spread_page(i) < ctx.get_page_count()) pages.insert(ctx.spread_page(i));
+  }
+  if (banks.size()==ctx.get_bank_count() && pages.size()==ctx.get_page_count()) return true;
+  std::fprintf(stderr, "%s: the rotations visit %zu of %zu banks and %zu of %zu superpages.\n", name.c_str(),
+               banks.size(), ctx.get_bank_count(), pages.size(), ctx.get_page_count());
+  return false;
+}
+
+static bool check_translations(const std::string &name, const std::vector<size_t> &expected,
+                               const std::vector<size_t> &actual, const std::vector<size_t> &inputs) {
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (actual[i]==expected[i]) continue;
+    std::fprintf(stderr, "%s translates %zx to %zx instead of %zx.\n", name.c_str(), inputs[i], actual[i], expected[i]);
+    return false;
+  }
+  return true;
+}
+
+// Checks, for each given config, that the lookup tables, the batch kernel (GFNI if the CPU supports it), and the
+// builtin mapping compiled from the config translate random addresses in both directions exactly like the bitwise
+// matrix products, that DRAMAddr maps them to valid coordinates and back, that the bank and superpage rotations visit
+// each bank and superpage once, and that every builtin mapping was checked.
+// Usage: test_translation <config file>...
+int main(int argc, char **argv) {
+  auto start_address = (volatile char *) (64*(size_t) HUGEPAGE_SIZE);
+  std::set<std::string> checked_mappings;
+  bool ok = true;
+
+  for (int arg = 1; arg < argc; ++arg) {
+    const BlacksmithConfig config = BlacksmithConfig::from_jsonfile(argv[arg]);
+    const TranslationContext ctx(config, start_address, 1);
+    // a config under another name is not compiled into a builtin mapping, so this context uses the lookup tables and
+    // the batch kernel selected for this CPU
+    BlacksmithConfig renamed = config;
+    renamed.name += " (test)";
+    const TranslationContext lut_ctx(renamed, start_address, 1);
+    const MemConfiguration &mc = ctx.get_mem_config();
+    std::printf("%s: batch kernels %s and %s\n", config.name.c_str(), lut_ctx.get_batch_kernel_name(),
+                ctx.get_batch_kernel_name());
+
+    std::mt19937_64 gen(arg);
+    std::vector<size_t> addrs(NUM_ADDRESSES), linears(NUM_ADDRESSES), offsets(NUM_ADDRESSES);
+    for (size_t i = 0; i < NUM_ADDRESSES; ++i) {
+      offsets[i] = gen() & (HUGEPAGE_SIZE - 1);
+      addrs[i] = (size_t) start_address + offsets[i];
+      linears[i] = apply_bitwise(mc.DRAM_MTX, mc.WIDTH, offsets[i]);
+      // the inverse maps the DRAM address back to the offset, which holds no bits above the superpage
+      if (apply_bitwise(mc.ADDR_MTX, mc.WIDTH, linears[i])!=offsets[i]) {
+        std::fprintf(stderr, "%s: the matrices of the config are not inverse to each other.\n", config.name.c_str());
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::vector<size_t> out(NUM_ADDRESSES);
+    for (const TranslationContext *c : {&lut_ctx, &ctx}) {
+      const std::string prefix = config.name + ((c==&ctx) ? " (builtin mapping)" : " (lookup tables)");
+      for (size_t i = 0; i < NUM_ADDRESSES; ++i) out[i] = c->to_dram(addrs[i]);
+      ok &= check_translations(prefix + " to_dram", linears, out, addrs);
+      for (size_t i = 0; i < NUM_ADDRESSES; ++i) out[i] = c->to_addr(linears[i]);
+      ok &= check_translations(prefix + " to_addr", offsets, out, linears);
+
+      const std::string batch_prefix = config.name + " (" + c->get_batch_kernel_name() + ")";
+      std::fill(out.begin(), out.end(), 0);
+      c->to_dram_batch(addrs.data(), out.data(), NUM_ADDRESSES);
+      ok &= check_translations(batch_prefix + " to_dram_batch", linears, out, addrs);
+      std::fill(out.begin(), out.end(), 0);
+      c->to_addr_batch(linears.data(), out.data(), NUM_ADDRESSES);
+      ok &= check_translations(batch_prefix + " to_addr_batch", offsets, out, linears);
+
+      ok &= check_dram_addrs(prefix, *c, addrs);
+    }
+    ok &= check_rotations(config.name, ctx);
+
+    if (std::strcmp(ctx.get_batch_kernel_name(), "builtin mapping")==0) checked_mappings.insert(config.name);
+  }
+
+  for (const auto &m : get_builtin_mappings()) {
+    if (checked_mappings.count(m.name)!=0) continue;
+    std::fprintf(stderr, "The builtin mapping %s was not checked, pass its config file.\n", m.name);
+    ok = false;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}